@@ -0,0 +1,112 @@
+#ifndef ALERTS_H
+#define ALERTS_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "price.h"
+#include "snapshot.h"
+
+struct AlertRule {
+  enum class Kind {
+    CrossAbove,   // last moves from below to at/above threshold
+    CrossBelow,   // last moves from above to at/below threshold
+    PercentMove,  // |move over window| reaches percent
+    SpreadAbove,  // sell - buy widens to at/above threshold
+  };
+
+  std::string symbol;
+  Kind kind = Kind::CrossAbove;
+  Price threshold;                   // CrossAbove, CrossBelow, SpreadAbove
+  double percent = 0;                // PercentMove
+  std::chrono::seconds window{0};    // PercentMove
+
+  // "USD>120000", "USD<95000.5", "USD%2.5/15m", "USD~150".
+  static AlertRule parse(std::string_view spec);
+  std::string describe() const;
+  // Same text, appended to a fmt buffer without a temporary string.
+  fmt::appender describeTo(fmt::appender out) const;
+};
+
+struct AlertEvent {
+  std::uint32_t rule;
+  std::size_t symbolIndex;  // into the evaluated snapshot
+  double value;             // price, spread or percent that fired it
+};
+
+// Rules are compiled into per-symbol sorted threshold arrays. Every tick is
+// a crossing of some metric from its previous to its current value, so the
+// rules that fire are exactly the thresholds inside that interval: two
+// binary searches per metric and O(k) for the k hits, independent of how
+// many rules are registered.
+class AlertEngine {
+ public:
+  std::uint32_t add(AlertRule rule);
+  // Loads one rule per line; blank lines and '#' comments are skipped.
+  void loadFile(const std::string& path);
+  std::size_t size() const { return this->rules.size(); }
+  const AlertRule& rule(std::uint32_t id) const { return this->rules[id]; }
+
+  // Appends the rules fired between the previous snapshot and this one.
+  void evaluate(const Snapshot& snapshot, std::vector<AlertEvent>& out);
+
+ private:
+  struct Threshold {
+    Price value;
+    std::uint32_t rule;
+  };
+  struct PercentThreshold {
+    double percent;
+    std::uint32_t rule;
+  };
+  struct PercentTrack {
+    std::chrono::seconds window;
+    std::vector<PercentThreshold> thresholds;
+    double lastMove = 0;
+  };
+  struct Sample {
+    std::chrono::system_clock::time_point at;
+    Price last;
+  };
+  struct SymbolRules {
+    std::vector<Threshold> above;
+    std::vector<Threshold> below;
+    std::vector<Threshold> spread;
+    std::vector<PercentTrack> percent;
+    std::deque<Sample> history;
+    std::chrono::seconds maxWindow{0};
+    bool primed = false;
+    Price lastPrice;
+    Price lastSpread;
+  };
+
+  void compile();
+  void evaluateSymbol(SymbolRules& entry, std::size_t index, Price last,
+                      Price spread, std::chrono::system_clock::time_point at,
+                      std::vector<AlertEvent>& out);
+
+  // Transparent, so a snapshot's symbols are looked up without building a
+  // std::string per symbol per tick.
+  struct SymbolHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view symbol) const {
+      return std::hash<std::string_view>{}(symbol);
+    }
+  };
+
+  std::vector<AlertRule> rules;
+  std::unordered_map<std::string, SymbolRules, SymbolHash, std::equal_to<>>
+      bySymbol;
+  bool dirty = false;
+};
+
+#endif  // ALERTS_H
@@ -0,0 +1,13 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <cstdint>
+
+// Number of global operator new calls so far. allocCounter.cc replaces the
+// global allocation functions of the executable with counting versions so
+// the benchmarks can check that hot paths stay off the heap.
+std::uint64_t globalAllocationCount();
+// Bytes requested by those calls, cumulative (frees are not subtracted).
+std::uint64_t globalAllocatedBytes();
+
+#endif  // ALLOC_COUNTER_H
@@ -0,0 +1,25 @@
+#ifndef BENCH_H
+#define BENCH_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Context for benchmarks that drive the whole program rather than one
+// component.
+struct BenchOptions {
+  std::string self;  // argv[0], re-executed by the startup benchmark
+  std::string url;   // --url; startup needs a local stand-in server
+  std::string replay;       // --replay; pool and alloc replay it instead
+                            // of synthetic payloads
+  std::size_t workers = 0;  // --workers; pool scales up to this many,
+                            // coalesce and readers run this many threads
+};
+
+// Built-in micro benchmarks, run with `--bench <name>`. They work on
+// synthetic or replayed payloads so they need no network access.
+int runBenchmark(std::string_view name, const BenchOptions& options = {});
+// Comma separated list of the available benchmark names, for --help.
+std::string benchmarkNames();
+
+#endif  // BENCH_H
@@ -1,30 +1,9 @@
-
 #ifndef BITCOIN_H
 #define BITCOIN_H
 // Copyright(c)2022 Vishal Ahirwar.
-#include <cstdio>
-#include <iostream>
-#include <nlohmann/json.hpp>
-#include <string>
-
-#include "curlHandler.h"
-
-
-class BitCoin {
-  using json = nlohmann::json;
-
- public:
-  json fetch();
-  BitCoin();
-
- private:
-  constexpr static const char* const URL = "https://blockchain.info/ticker";
-  CurlHandler curlHandle;
+#include "ticker.h"
 
- private:
-  // Helper function for JSON validation and cleaning
-  std::string validateAndCleanJson(const std::string& rawData);
+// The original ticker: BTC from blockchain.info.
+using BitCoin = Ticker<Btc, BlockchainInfo>;
 
- protected:
-};
-#endif  // BITCOIN_H
\ No newline at end of file
+#endif  // BITCOIN_H
@@ -0,0 +1,114 @@
+#ifndef CANDLES_H
+#define CANDLES_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "price.h"
+#include "snapshot.h"
+
+struct CandleResolution {
+  std::string_view name;
+  std::chrono::seconds length;
+};
+
+// Every aggregator keeps all of these; indices into this table are the
+// `resolution` arguments below. Buckets are aligned to the Unix epoch, so
+// days run from 00:00 UTC.
+constexpr CandleResolution CANDLE_RESOLUTIONS[] = {
+    {"1m", std::chrono::minutes(1)},  {"5m", std::chrono::minutes(5)},
+    {"15m", std::chrono::minutes(15)}, {"1h", std::chrono::hours(1)},
+    {"1d", std::chrono::hours(24)},
+};
+constexpr std::size_t CANDLE_RESOLUTION_COUNT = std::size(CANDLE_RESOLUTIONS);
+
+// OHLC of the `last` price over one bucket. 40 bytes: the start is kept as
+// the bucket number (start / length) rather than a timestamp.
+struct Candle {
+  Price open;
+  Price high;
+  Price low;
+  Price close;
+  std::uint32_t bucket = 0;
+  std::uint32_t ticks = 0;  // 0 = no candle
+
+  std::int64_t startMillis(std::size_t resolution) const;
+};
+
+struct ClosedCandle {
+  std::uint32_t symbol;  // CandleAggregator::symbol(id)
+  std::uint8_t resolution;
+  Candle candle;
+};
+
+// Incremental candles for every symbol at every resolution. A tick folds
+// each symbol's last price into its open candles: O(1) per symbol and
+// resolution, the series laid out per resolution so the pass is a linear
+// walk. When a tick's time falls into a later bucket, the open candles of
+// that resolution are closed first (once per boundary, not per tick) and
+// moved into a ring of the `keep` most recent per symbol. Symbols without
+// a tick in a bucket have no candle for it.
+//
+// Symbols get stable ids on first sight; while the snapshot's symbol set
+// is unchanged (Snapshot::symbolsHash) the index -> id map is reused, so
+// thousands of symbols cost no lookups per tick. A tick older than the
+// open bucket (a clock step back) counts towards the open candle.
+class CandleAggregator {
+ public:
+  static constexpr std::size_t DEFAULT_KEEP = 24;
+
+  explicit CandleAggregator(std::size_t keep = DEFAULT_KEEP);
+
+  // Folds the snapshot in at snapshot.fetchedAt, appending the candles
+  // that closed to `out`.
+  void update(const Snapshot& snapshot, std::vector<ClosedCandle>& out);
+  // Closes the candles whose bucket ended by `now` without waiting for the
+  // next tick.
+  void advance(std::chrono::system_clock::time_point now,
+               std::vector<ClosedCandle>& out);
+  // Closes every open candle as it stands, bucket over or not: at the end
+  // of a run, so its last candles are not lost. A later tick in the same
+  // bucket starts a new candle for it.
+  void closeAll(std::vector<ClosedCandle>& out);
+
+  std::size_t symbolCount() const { return this->names.size(); }
+  const std::string& symbol(std::uint32_t id) const { return this->names[id]; }
+  // The open candle of `symbol`, if it has ticked in the current bucket.
+  std::optional<Candle> current(std::string_view symbol,
+                                std::size_t resolution) const;
+  // Up to `keep` closed candles of `symbol`, oldest first. Both throw
+  // std::out_of_range for a resolution outside CANDLE_RESOLUTIONS.
+  std::vector<Candle> recent(std::string_view symbol,
+                             std::size_t resolution) const;
+
+ private:
+  struct Series {
+    std::uint32_t bucket = 0;  // open bucket; 0 until the first tick
+    std::vector<Candle> open;     // by symbol id
+    std::vector<Candle> ring;     // keep per symbol id
+    std::vector<std::uint32_t> closed;  // per symbol id, total ever
+  };
+
+  void mapSymbols(const Snapshot& snapshot);
+  void closeBefore(std::int64_t millis, std::vector<ClosedCandle>& out);
+  void closeOpen(std::size_t resolution, std::vector<ClosedCandle>& out);
+  std::optional<std::uint32_t> idOf(std::string_view symbol) const;
+
+  std::size_t keep;
+  std::vector<std::string> names;
+  std::unordered_map<std::string, std::uint32_t> ids;
+  std::vector<std::uint32_t> snapshotIds;  // snapshot index -> id
+  std::uint64_t symbolsHash = 0;
+  std::size_t mappedSize = 0;
+  std::array<Series, CANDLE_RESOLUTION_COUNT> series;
+};
+
+#endif  // CANDLES_H
@@ -0,0 +1,72 @@
+#ifndef CONNECTION_CACHE_H
+#define CONNECTION_CACHE_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "curlHandler.h"
+#include "dnsPrefetch.h"
+
+// What one --once process learned about reaching its endpoint, kept on
+// disk for the next: the resolved addresses, so a run from cron skips the
+// DNS lookup the previous one already paid for, and the TLS sessions
+// libcurl exports, so its handshake resumes. Sessions need a libcurl with
+// SSLS-EXPORT (CurlHandler::tlsSessionsSupported); without one only the
+// addresses are kept.
+//
+// Layout, little-endian: a 24-byte header ("BTCXCON3", u32 address count,
+// u32 session count, u64 FNV-1a of the rest), then the addresses (u16 host
+// length, host, u16 address count and that many u16 length + address, u32
+// port, i64 expiry in epoch seconds) and the sessions (u16 key length,
+// key, u32 shmac length, shmac, u32 data length, data, i64 expiry).
+// Written like SnapshotCache, through a uniquely named, owner-only
+// temporary file renamed over the old one: the sessions are resumption
+// secrets.
+class ConnectionCache {
+ public:
+  static constexpr std::size_t HEADER_BYTES = 24;
+  // Sessions kept at most; the oldest go first.
+  static constexpr std::size_t MAX_SESSIONS = 16;
+  // Addresses are trusted this long; DNS TTLs are not visible to us.
+  static constexpr std::chrono::minutes ADDRESS_TTL{10};
+
+  explicit ConnectionCache(std::string path);
+  // bitcoinexrc/connect.bin next to SnapshotCache::defaultPath(); empty
+  // if that is.
+  static std::string defaultPath();
+
+  const std::string& path() const { return this->file; }
+  // False if there is no cache or it fails validation (it is then empty).
+  bool load();
+  // Throws std::runtime_error if the file cannot be written.
+  void save() const;
+  // Empties the cache and removes the file, e.g. after a failed connect
+  // through a cached address.
+  void discard();
+
+  // Unexpired cached address of host:port.
+  std::optional<ResolvedAddress> address(const std::string& host,
+                                         long port) const;
+  void remember(const ResolvedAddress& resolved);
+
+  const std::vector<TlsSession>& sessions() const { return this->tls; }
+  // Replaces sessions with the same key and keeps the others; expired ones
+  // are dropped.
+  void keepSessions(const std::vector<TlsSession>& sessions);
+
+ private:
+  struct Address {
+    ResolvedAddress resolved;
+    std::int64_t expiresAt = 0;  // epoch seconds
+  };
+
+  std::string file;
+  std::vector<Address> addresses;
+  std::vector<TlsSession> tls;
+};
+
+#endif  // CONNECTION_CACHE_H
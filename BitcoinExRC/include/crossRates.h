@@ -0,0 +1,57 @@
+#ifndef CROSS_RATES_H
+#define CROSS_RATES_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "snapshot.h"
+
+// Fiat-to-fiat cross rates implied by the BTC prices of a snapshot.
+// rate(field, base, quote) is how many units of `quote` one unit of `base`
+// buys, i.e. price[quote] / price[base]. Each matrix is stored row-major
+// (row = base) so a row is one contiguous SIMD-friendly scale of the price
+// array by 1 / price[base].
+class CrossRateEngine {
+ public:
+  enum class Field { Last = 0, Buy = 1, Sell = 2 };
+  static constexpr std::size_t FIELD_COUNT = 3;
+
+  // Full N x N recompute for all fields.
+  void compute(const Snapshot& snapshot);
+  // Recompute only rows/columns of symbols whose prices moved since the last
+  // compute/update. Falls back to compute() when the symbol set changed.
+  // Returns the number of symbols that were refreshed.
+  std::size_t update(const Snapshot& snapshot);
+  // Same, with the caller supplying the changed symbol indices.
+  void update(const Snapshot& snapshot, std::span<const std::size_t> changed);
+
+  std::size_t size() const { return this->symbols.size(); }
+  const std::vector<std::string>& symbolNames() const { return this->symbols; }
+  double rate(Field field, std::size_t base, std::size_t quote) const;
+  // Row `base` of the matrix: rates from base to every symbol.
+  std::span<const double> row(Field field, std::size_t base) const;
+
+ private:
+  // Prices are widened to double once per symbol; the matrices are ratios
+  // and do not need the fixed-point representation.
+  struct Plane {
+    std::vector<double> price;
+    std::vector<double> inverse;
+    std::vector<double> matrix;
+  };
+
+  static const std::pmr::vector<Price>& source(const Snapshot& snapshot,
+                                                Field field);
+  bool sameSymbols(const Snapshot& snapshot) const;
+  void load(const Snapshot& snapshot);
+  void refreshRow(Plane& plane, std::size_t base) const;
+  void refreshColumn(Plane& plane, std::size_t quote) const;
+
+  std::vector<std::string> symbols;
+  Plane planes[FIELD_COUNT];
+  std::vector<std::size_t> changedRows;  // update() scratch, kept per tick
+};
+
+#endif  // CROSS_RATES_H
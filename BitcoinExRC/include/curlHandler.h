@@ -2,17 +2,83 @@
 #define CURL_HANDLER_H
 //Copyright(c)2022 Vishal Ahirwar.
 #include <memory>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <curl/curl.h>
 #include <functional>
+#include <optional>
 #include <string>
+#include <vector>
+#include "freshness.h"
 typedef std::unique_ptr<CURL, std::function<void(CURL *)>> curl_ptr;
+typedef std::unique_ptr<curl_slist, void (*)(curl_slist *)> curl_slist_ptr;
+
+// Phase timings of the last transfer, in milliseconds from its start.
+struct TransferTimings
+{
+  double dns = 0;
+  double connect = 0;
+  double tls = 0;
+  double firstByte = 0;
+  double total = 0;
+};
+
+// A TLS session libcurl can resume from, as it exports them: opaque apart
+// from the expiry.
+struct TlsSession
+{
+  std::string key;    // curl's session key (peer and TLS settings)
+  std::string shmac;  // salted hash of the key
+  std::string data;   // serialized session / ticket
+  std::int64_t validUntil = 0;  // epoch seconds, 0 = unknown
+};
+
 class CurlHandler
 {
 public:
   CurlHandler();
   void setUrl(const std::string &url);
+  // Pins host:port to already resolved addresses (CURLOPT_RESOLVE) so the
+  // transfer skips its own DNS lookup; curl still falls back from one to
+  // the next. An empty list unpins.
+  void setResolvedAddress(const std::string &host, long port,
+                          const std::vector<std::string> &addresses);
+  TransferTimings timings() const;
+  // Closes the connection after every transfer when false, so the next
+  // one connects again and resumes its TLS session from this handle's
+  // session cache. For handshake measurements; reuse is the default.
+  void setConnectionReuse(bool reuse);
+
+  // TLS sessions in this handle's cache, and seeding a fresh handle with
+  // them so its first connect resumes instead of doing a full handshake.
+  // Needs libcurl 8.12+ built with SSLS-EXPORT, checked at runtime: without
+  // it there is nothing to export and importing takes nothing.
+  static bool tlsSessionsSupported();
+  std::vector<TlsSession> exportTlsSessions() const;
+  // Returns how many of `sessions` were taken (expired ones are skipped).
+  std::size_t importTlsSessions(const std::vector<TlsSession> &sessions);
+  // Clock skew, one-way latency and data age estimated from the last
+  // response's Date, Age and Last-Modified headers (see freshness.h).
+  Freshness freshness() const { return this->lastFreshness; }
+
+  // Largest response body accepted, in bytes (0 = no limit). A larger
+  // Content-Length aborts the transfer before any of the body is read; a
+  // body without one (or compressed) is cut off as soon as it grows past.
+  void setMaxBody(std::size_t bytes) { this->body.maxBody = bytes; }
+  std::size_t maxBody() const { return this->body.maxBody; }
+  static constexpr std::size_t DEFAULT_MAX_BODY = std::size_t{64} << 20;
+  // Times the body buffer had to grow during the last transfer: 0 when it
+  // was presized from Content-Length (up to 4 MiB) or reused a large
+  // enough buffer.
+  std::size_t lastBodyGrowths() const { return this->body.growths; }
 
-  const std::string getFetchedData() const;
+  const std::string& getFetchedData() const;
+  // Moves the body out, e.g. to hand it to another thread. Give it back
+  // with recycle() once done so its capacity serves a later transfer.
+  std::string takeFetchedData();
+  // Returns a taken body to the process-wide pool of body buffers.
+  static void recycle(std::string&& body);
 public:
     // ... your existing public methods ...
     
@@ -21,14 +87,41 @@ public:
     
     // Modified fetch method signature (remove const if it was const)
     CURLcode fetch();  // Note: removed const since we're modifying data
-private:
-  curl_ptr curlptr;
-  std::string data{};
+
+  // curl_global_init() (which initializes the TLS library) runs once per
+  // process, on first use, before the easy handle is created.
+  static CURL *createHandle();
   constexpr static auto deleter = [](CURL *c)
   {
     curl_easy_cleanup(c);
-    curl_global_cleanup();
   };
+private:
+  // Response body plus what the header callback learned about it.
+  struct Body
+  {
+    std::string data;
+    std::size_t maxBody = DEFAULT_MAX_BODY;
+    std::size_t expected = 0;  // Content-Length, 0 if none was sent
+    bool encoded = false;      // Content-Encoding: length is not the body's
+    bool sized = false;        // buffer prepared for this response
+    bool tooLarge = false;
+    bool outOfMemory = false;  // growing the buffer threw in onBody
+    std::size_t growths = 0;
+    std::optional<std::chrono::system_clock::time_point> date;
+    std::optional<std::chrono::system_clock::time_point> lastModified;
+    std::chrono::seconds age{0};
+  };
+  static std::size_t onHeader(char *buffer, std::size_t size,
+                              std::size_t count, void *userData);
+  static std::size_t onBody(char *buffer, std::size_t size,
+                            std::size_t count, void *userData);
+  Freshness estimateFreshness(
+      std::chrono::system_clock::time_point localStart) const;
+
+  curl_ptr curlptr;
+  curl_slist_ptr resolve{nullptr, curl_slist_free_all};
+  Body body;
+  Freshness lastFreshness;
 
 protected:
 };
@@ -0,0 +1,64 @@
+#ifndef DELTA_ENCODER_H
+#define DELTA_ENCODER_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "price.h"
+#include "snapshot.h"
+
+// Which price fields of a symbol a delta carries.
+enum DeltaField : std::uint8_t {
+  DELTA_M15 = 1,
+  DELTA_LAST = 2,
+  DELTA_BUY = 4,
+  DELTA_SELL = 8,
+  DELTA_ALL = 15,
+};
+
+// One tick's changes. Symbol ids are indices into the snapshot and stay
+// valid until the next keyframe; a keyframe lists every symbol with
+// DELTA_ALL and is the only place the names travel.
+struct DeltaFrame {
+  bool keyframe = false;
+  std::vector<std::uint32_t> ids;
+  std::vector<std::uint8_t> fields;  // DeltaField bits, parallel to ids
+
+  std::size_t size() const { return this->ids.size(); }
+};
+
+// Change detection between consecutive snapshots. The price arrays are
+// compared eight symbols at a time with SIMD XOR/OR (AVX2 or SSE2, scalar
+// otherwise); only blocks that differ are walked per symbol, so a tick
+// where little moved costs a streaming pass over the prices. A keyframe
+// is emitted on the first tick, every `keyframeEvery` ticks (0 = only when
+// forced) and whenever the symbol set changes, which is detected through
+// Snapshot::symbolsHash rather than by comparing names.
+class DeltaEncoder {
+ public:
+  static constexpr std::size_t DEFAULT_KEYFRAME_EVERY = 60;
+
+  explicit DeltaEncoder(std::size_t keyframeEvery = DEFAULT_KEYFRAME_EVERY);
+
+  // Diffs `next` against the previous snapshot and remembers it. The frame
+  // is reused: valid until the next call.
+  const DeltaFrame& encode(const Snapshot& next);
+  void forceKeyframe() { this->primed = false; }
+
+ private:
+  void keyframe(const Snapshot& next);
+
+  std::size_t keyframeEvery;
+  std::size_t sinceKeyframe = 0;
+  bool primed = false;
+  std::size_t symbolCount = 0;
+  std::uint64_t symbolsHash = 0;
+  std::vector<Price> m15;
+  std::vector<Price> last;
+  std::vector<Price> buy;
+  std::vector<Price> sell;
+  DeltaFrame frame;
+};
+
+#endif  // DELTA_ENCODER_H
@@ -0,0 +1,30 @@
+#ifndef DNS_PREFETCH_H
+#define DNS_PREFETCH_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <future>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct ResolvedAddress {
+  std::string host;
+  long port = 0;
+  // Numeric, e.g. "104.16.1.2" or "2606:4700::1", in resolver order. All
+  // of them are pinned, so curl keeps its fallback between addresses and
+  // happy eyeballs between families.
+  std::vector<std::string> addresses;
+};
+
+// Splits "scheme://host[:port]/..." into host and port (defaulting from the
+// scheme). Returns nullopt for URLs it does not understand.
+std::optional<ResolvedAddress> parseUrlHost(const std::string& url);
+
+// Resolves the host of `url` on a background thread so the lookup overlaps
+// libcurl/TLS initialization. Only families with a configured local
+// address are asked for (AI_ADDRCONFIG). Yields nullopt when resolution
+// fails or is not supported, in which case curl simply resolves on its
+// own.
+std::future<std::optional<ResolvedAddress>> prefetchAddress(
+    const std::string& url);
+
+#endif  // DNS_PREFETCH_H
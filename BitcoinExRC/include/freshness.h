@@ -0,0 +1,35 @@
+#ifndef FRESHNESS_H
+#define FRESHNESS_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <cstdint>
+
+// When a snapshot's prices were produced, on the local clock, and how that
+// was worked out. Estimated per request: the server stamped its Date
+// header somewhere between our request going out and its first byte
+// coming back, so the midpoint of that window is the same instant on our
+// clock, and skew is Date minus midpoint (good to the header's one second
+// resolution). Any Age a cache reports, or a Last-Modified older than
+// that, is subtracted from the midpoint.
+struct Freshness {
+  using Clock = std::chrono::system_clock;
+
+  Clock::time_point sourceAt{};        // epoch = unknown
+  std::chrono::nanoseconds skew{0};    // server clock minus ours
+  std::chrono::nanoseconds oneWay{0};  // half the request/response window
+  bool serverDated = false;            // skew is from a Date header
+
+  bool known() const { return this->sourceAt != Clock::time_point{}; }
+  std::chrono::nanoseconds ageAt(Clock::time_point now) const {
+    return now - this->sourceAt;
+  }
+  // Age in whole milliseconds at `now`, -1 if unknown (the sink encoding).
+  std::int64_t ageMillis(Clock::time_point now) const {
+    if (!this->known()) return -1;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               this->ageAt(now))
+        .count();
+  }
+};
+
+#endif  // FRESHNESS_H
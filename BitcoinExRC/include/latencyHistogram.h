@@ -0,0 +1,90 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// HDR-style histogram of durations in nanoseconds. Values below 256 ns get
+// a bucket each; above that every power of two is split into 128 linear
+// sub-buckets, so any recorded value is known to within 1/128 (~0.8%)
+// across the whole range, 1 ns to 2^40 ns (~18 minutes; longer clamps).
+//
+// record() is a handful of relaxed atomic adds with no locks, so stages on
+// different threads can share one histogram. Histograms with the same
+// layout merge by adding bucket counts, which is what makes dumps from
+// many processes combinable.
+class LatencyHistogram {
+ public:
+  static constexpr unsigned SUB_BITS = 8;
+  static constexpr unsigned MAX_BITS = 40;
+  static constexpr std::size_t SUB_COUNT = std::size_t{1} << SUB_BITS;
+  static constexpr std::size_t HALF_COUNT = SUB_COUNT / 2;
+  static constexpr std::size_t BUCKETS =
+      SUB_COUNT + (MAX_BITS - SUB_BITS) * HALF_COUNT;
+
+  LatencyHistogram() = default;
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void record(std::chrono::nanoseconds value);
+  // Adds every sample of `other`; safe while others keep recording.
+  void add(const LatencyHistogram& other);
+
+  std::uint64_t count() const { return this->total.load(); }
+  std::chrono::nanoseconds min() const;
+  std::chrono::nanoseconds max() const;
+  std::chrono::nanoseconds mean() const;
+  // Value at quantile q (0..1): the top of the bucket holding that rank,
+  // capped at max().
+  std::chrono::nanoseconds valueAt(double q) const;
+
+  // One line: count, p50, p90, p99, p99.9, max.
+  void print(std::FILE* out, std::string_view name) const;
+
+  // Text form, one line: `<name> <sub bits> <max bits> <count> <min ns>
+  // <max ns> <sum ns> <bucket>:<count>...` with empty buckets left out.
+  std::string serialize(std::string_view name) const;
+  // Adds the samples of a serialize()d line whose name was already split
+  // off. Throws std::runtime_error on a malformed or incompatible line.
+  void mergeSerialized(std::string_view fields);
+
+  static std::size_t bucketOf(std::uint64_t value);
+  // Largest value that lands in `bucket`.
+  static std::uint64_t bucketTop(std::size_t bucket);
+
+ private:
+  void recordCount(std::size_t bucket, std::uint64_t count);
+  void noteExtremes(std::uint64_t low, std::uint64_t high);
+
+  std::array<std::atomic<std::uint64_t>, BUCKETS> counts{};
+  std::atomic<std::uint64_t> total{0};
+  std::atomic<std::uint64_t> sum{0};
+  std::atomic<std::uint64_t> lowest{UINT64_MAX};
+  std::atomic<std::uint64_t> highest{0};
+};
+
+// The histograms kept over a polling run: end-to-end tick latency (fetch
+// start to frame or records written), each stage, and scheduler wakeup
+// lateness. Printed on exit; --histograms saves them for later merging.
+struct LatencyReport {
+  LatencyHistogram tick;
+  LatencyHistogram fetch;
+  LatencyHistogram decode;
+  LatencyHistogram output;
+  LatencyHistogram jitter;
+  LatencyHistogram age;  // data age at output, where it is known
+
+  // Skips histograms with no samples; prints nothing if all are empty.
+  void print(std::FILE* out) const;
+  // Throws std::runtime_error if the file cannot be written or read.
+  void save(const std::string& path) const;
+  void merge(const std::string& path);
+};
+
+#endif  // LATENCY_HISTOGRAM_H
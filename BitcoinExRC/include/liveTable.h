@@ -0,0 +1,71 @@
+#ifndef LIVE_TABLE_H
+#define LIVE_TABLE_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "alerts.h"
+#include "crossRates.h"
+#include "render.h"
+#include "snapshot.h"
+#include "snapshotCache.h"
+#include "taskPool.h"
+#include "tickArena.h"
+#include "tickerSchema.h"
+
+// The terminal table's work for one tick once its prices are in. Cross
+// rates, alerts and the snapshot cache run as pool tasks while the calling
+// thread renders the rates table; the cross-rate matrix and the alerts
+// that fired are drawn once those tasks are done. Frames are formatted on
+// the tick arena and written in one call each.
+//
+// Everything a tick needs (arena, engines, event list, cross-table
+// columns, the cache's encode buffer) is kept across ticks, so a
+// steady-state tick does not touch the global heap. --bench alloc drives
+// this same path and fails if that stops being true.
+class LiveTable {
+ public:
+  struct Options {
+    // Shown as the refresh rate; 0 labels the table as fed by a stream.
+    std::chrono::milliseconds interval{0};
+    AssetInfo asset = Btc::INFO;
+    bool showCross = false;
+    std::vector<std::string> crossSymbols;  // matrix columns; empty = all
+    const SnapshotCache* cache = nullptr;   // saved to on every tick
+    std::FILE* out = stdout;
+  };
+
+  LiveTable(TaskPool& pool, AlertEngine& alerts, Options options);
+  LiveTable(const LiveTable&) = delete;
+  LiveTable& operator=(const LiveTable&) = delete;
+
+  // Starts a tick by resetting the arena: whatever the last tick built on
+  // it must be gone. Decode the tick's snapshot onto it.
+  TickArena& beginTick();
+  // Draws `snapshot` as update number `update`, over a cleared screen if
+  // `clear`, with its cross rates and alerts, and persists it.
+  void show(const Snapshot& snapshot, int update, bool clear = true);
+
+  const CrossRateEngine& crossRates() const { return this->cross; }
+  // The alerts the last show() fired.
+  const std::vector<AlertEvent>& alertEvents() const { return this->events; }
+
+ private:
+  void persist(const Snapshot& snapshot);
+  void renderCross(FrameBuffer& out);
+  void renderAlerts(FrameBuffer& out) const;
+
+  TaskPool& pool;
+  AlertEngine& alerts;
+  Options options;
+  TickArena arena;
+  CrossRateEngine cross;
+  std::vector<AlertEvent> events;
+  std::vector<std::size_t> columns;  // cross-table symbol indices
+  bool cacheFailed = false;          // reported once
+};
+
+#endif  // LIVE_TABLE_H
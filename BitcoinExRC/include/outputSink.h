@@ -0,0 +1,160 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "candles.h"
+#include "deltaEncoder.h"
+#include "snapshot.h"
+
+// Buffers output and hands it to stdio in large blocks. Records are
+// formatted straight into the buffer through reserve()/commit(), so the
+// per-record cost is formatting only, not a write call.
+class BatchWriter {
+ public:
+  static constexpr std::size_t DEFAULT_CAPACITY = 1 << 16;
+
+  // Takes ownership of `out` unless it is stdout.
+  explicit BatchWriter(std::FILE* out,
+                       std::size_t capacity = DEFAULT_CAPACITY);
+  BatchWriter(const BatchWriter&) = delete;
+  BatchWriter& operator=(const BatchWriter&) = delete;
+  ~BatchWriter();
+
+  // Returns room for at least `bytes`; flushes first if needed.
+  char* reserve(std::size_t bytes);
+  void commit(char* end) {
+    this->used = static_cast<std::size_t>(end - this->buffer.data());
+  }
+  void append(std::string_view text);
+  // Hands the buffer to stdio and flushes the stream.
+  void flush();
+  // Everything committed so far, flushed or not.
+  std::uint64_t bytes() const { return this->written + this->used; }
+
+ private:
+  void drain();
+
+  std::FILE* out;
+  std::vector<char> buffer;
+  std::size_t used = 0;
+  std::uint64_t written = 0;
+};
+
+enum class OutputFormat { Ndjson, Csv, Binary };
+
+// Closed OHLC candles of every tick written to their own stream in the
+// records' format, one record per symbol and resolution:
+//   ndjson {"candle":"5m","symbol":"USD","start":ms,"open":..,"high":..,
+//           "low":..,"close":..,"ticks":n}
+//   csv    candle,symbol,start,open,high,low,close,ticks
+//   bin    "BTCXCDL1", then 56-byte records: i64 start_ms, u32 length_s,
+//          u32 ticks, char[8] symbol, i64 cents x4 (open, high, low, close)
+// bin refuses symbols longer than 8 bytes, as OutputSink does.
+// A candle is written when its bucket is over (at a tick, or at advance()
+// between ticks). When the sink is destroyed the candles still open are
+// written as they stand, so the first and last candle of a run may only
+// cover the part of their bucket the run saw.
+class CandleSink {
+ public:
+  // `path` empty or "-" means stdout.
+  CandleSink(OutputFormat format, const std::string& path,
+             std::size_t keep = CandleAggregator::DEFAULT_KEEP);
+  CandleSink(const CandleSink&) = delete;
+  CandleSink& operator=(const CandleSink&) = delete;
+  ~CandleSink();
+
+  void write(const Snapshot& snapshot);
+  // Writes the candles whose bucket ended by `now`, for ticks that did not
+  // arrive (a failed fetch, a quiet stream).
+  void advance(std::chrono::system_clock::time_point now);
+  void flush() { this->writer.flush(); }
+  std::uint64_t records() const { return this->recordCount; }
+  const CandleAggregator& aggregator() const { return this->candles; }
+
+ private:
+  OutputFormat format;
+  BatchWriter writer;
+  CandleAggregator candles;
+  void writeClosed();
+
+  std::vector<ClosedCandle> closed;
+  std::uint64_t recordCount = 0;
+};
+
+// Machine-readable streaming output: one record per symbol per tick, no
+// ANSI, no animation. Ticks are batched and flushed every `flushEvery`
+// ticks (0 = only when the buffer fills and at exit).
+//
+// With `deltaKeyframeEvery` set, ticks go through a DeltaEncoder instead:
+// a keyframe with every symbol (and its id) on the first tick and every
+// `deltaKeyframeEvery` ticks after, and in between only the symbols whose
+// prices moved, by id, with just the fields that changed.
+//
+// Every record also carries the data's age in milliseconds when it was
+// written (Snapshot::freshness); ndjson omits it, csv leaves it empty and
+// bin writes -1 where the age is unknown.
+//
+// csv quotes a symbol holding a comma, quote or line break (RFC 4180).
+// bin holds symbols in 8 bytes and throws std::runtime_error for a longer
+// one instead of cutting it; nothing of that tick is written.
+//
+// A CandleSink set with setCandles() is fed every tick written here.
+class OutputSink {
+ public:
+  // What every record of one tick shares, worked out once per tick.
+  struct TickStamp {
+    std::uint64_t tick = 0;
+    std::int64_t ts = 0;      // fetchedAt, ms since the epoch
+    std::int64_t ageMs = -1;  // -1 = unknown
+  };
+
+  OutputSink(const OutputSink&) = delete;
+  OutputSink& operator=(const OutputSink&) = delete;
+  virtual ~OutputSink() = default;
+
+  // `path` empty or "-" means stdout.
+  static std::unique_ptr<OutputSink> create(
+      OutputFormat format, const std::string& path, std::size_t flushEvery,
+      std::size_t deltaKeyframeEvery = 0);
+  static OutputFormat parseFormat(std::string_view name);
+
+  void write(const Snapshot& snapshot);
+  // Lets the candles close on the clock when no tick was written.
+  void advance(std::chrono::system_clock::time_point now);
+  void flush();
+  std::uint64_t records() const { return this->recordCount; }
+  std::uint64_t bytes() const { return this->writer.bytes(); }
+  bool deltas() const { return this->delta != nullptr; }
+  void setCandles(std::unique_ptr<CandleSink> sink) {
+    this->candles = std::move(sink);
+  }
+  const CandleSink* candleSink() const { return this->candles.get(); }
+
+ protected:
+  OutputSink(std::FILE* out, std::size_t flushEvery,
+             std::size_t deltaKeyframeEvery);
+  virtual void writeRecords(const Snapshot& snapshot,
+                            const TickStamp& stamp) = 0;
+  virtual void writeDelta(const Snapshot& snapshot, const DeltaFrame& frame,
+                          const TickStamp& stamp) = 0;
+
+  BatchWriter writer;
+  std::uint64_t recordCount = 0;
+  std::unique_ptr<DeltaEncoder> delta;
+
+ private:
+  std::unique_ptr<CandleSink> candles;
+  std::size_t flushEvery;
+  std::uint64_t tick = 0;
+};
+
+#endif  // OUTPUT_SINK_H
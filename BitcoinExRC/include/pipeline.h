@@ -0,0 +1,89 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "latencyHistogram.h"
+#include "snapshot.h"
+#include "spscQueue.h"
+#include "tickScheduler.h"
+#include "ticker.h"
+#include "tickerDecoder.h"
+
+struct PipelineOptions {
+  std::size_t depth = 4;  // per queue, rounded up to a power of two
+  OverflowPolicy overflow = OverflowPolicy::DropOldest;
+  std::chrono::milliseconds interval{3000};
+  bool alignToWallClock = false;
+
+  // "block" or "drop-oldest".
+  static OverflowPolicy parseOverflow(std::string_view name);
+};
+
+// Fetch, decode and output as three threads joined by bounded SPSC queues,
+// so a slow render no longer pushes back the next fetch (drop-oldest) or
+// does so explicitly (block). The network stage keeps absolute deadlines
+// and stops on the shutdown wakeup; closing its queue drains the rest.
+class Pipeline {
+ public:
+  // Runs on the output thread, once per decoded tick.
+  using Output = std::function<void(const Snapshot&)>;
+
+  // Stage, end-to-end and jitter latencies are recorded into `latency`.
+  Pipeline(TickerClient& ticker, const TickerDecoder& decoder,
+           PipelineOptions options, LatencyReport& latency);
+
+  // Starts the stages and returns once all three have finished: after one
+  // tick unless `realTime`, otherwise on shutdown.
+  void run(const Output& output, bool realTime);
+  // Per-queue depth, drop and backpressure figures plus per-stage busy
+  // time; call after run().
+  void printMetrics(std::FILE* out) const;
+  // Ticks that reached the output callback, and ticks lost to a failed
+  // fetch, decode or output; call after run().
+  std::uint64_t written() const { return this->writing.items; }
+  std::uint64_t errors() const {
+    return this->network.errors + this->decoding.errors +
+           this->writing.errors;
+  }
+
+ private:
+  struct RawTick {
+    std::uint64_t tick = 0;
+    std::chrono::steady_clock::time_point started;
+    std::string body;
+    Freshness freshness;
+  };
+  struct DecodedTick {
+    std::uint64_t tick = 0;
+    std::chrono::steady_clock::time_point started;
+    Snapshot snapshot;
+  };
+  struct StageMetrics {
+    std::uint64_t items = 0;
+    std::uint64_t errors = 0;
+    std::chrono::nanoseconds busy{0};
+  };
+
+  void networkStage(bool realTime);
+  void decodeStage();
+  void outputStage(const Output& output);
+
+  TickerClient& ticker;
+  const TickerDecoder& decoder;
+  PipelineOptions options;
+  SpscQueue<RawTick> fetched;
+  SpscQueue<DecodedTick> decoded;
+  StageMetrics network;
+  StageMetrics decoding;
+  StageMetrics writing;
+  LatencyReport& latency;
+};
+
+#endif  // PIPELINE_H
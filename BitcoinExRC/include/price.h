@@ -0,0 +1,83 @@
+#ifndef PRICE_H
+#define PRICE_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <fmt/format.h>
+
+#include <charconv>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Exact two-decimal price stored as a signed count of hundredths ("cents").
+// Parsed straight from the JSON number text, so large quotes such as ARS
+// never round-trip through binary floating point on their way to the
+// screen.
+class Price {
+ public:
+  static constexpr std::int64_t SCALE = 100;
+  // Longest formatted value: sign, 17 integer digits, '.', 2 decimals.
+  static constexpr std::size_t MAX_CHARS = 21;
+
+  constexpr Price() = default;
+  static constexpr Price fromCents(std::int64_t cents) { return Price(cents); }
+  // Rounds half away from zero to the nearest cent.
+  static Price fromDouble(double value);
+  // std::from_chars-style parse of a JSON number at the start of
+  // [first, last): a from_chars fast path for plain decimals, extra decimals
+  // rounded half away from zero, exponent forms through the double parser.
+  static std::from_chars_result fromChars(const char* first, const char* last,
+                                          Price& out);
+  // Parses a whole string; false on malformed or out-of-range text.
+  static bool parse(std::string_view text, Price& out);
+
+  constexpr std::int64_t cents() const { return this->value; }
+  constexpr double toDouble() const {
+    return static_cast<double>(this->value) / SCALE;
+  }
+
+  // Writes the value as "-123.45" into `out` (at least MAX_CHARS bytes) and
+  // returns one past the last character written.
+  char* formatTo(char* out) const;
+  std::string toString() const;
+
+  constexpr Price operator+(Price other) const {
+    return Price(this->value + other.value);
+  }
+  constexpr Price operator-(Price other) const {
+    return Price(this->value - other.value);
+  }
+  constexpr Price operator-() const { return Price(-this->value); }
+  constexpr Price& operator+=(Price other) {
+    this->value += other.value;
+    return *this;
+  }
+  constexpr Price& operator-=(Price other) {
+    this->value -= other.value;
+    return *this;
+  }
+  constexpr Price operator*(std::int64_t factor) const {
+    return Price(this->value * factor);
+  }
+  constexpr auto operator<=>(const Price&) const = default;
+
+ private:
+  constexpr explicit Price(std::int64_t cents) : value(cents) {}
+  std::int64_t value = 0;
+};
+
+// Formats through Price::formatTo, so width/alignment specs such as
+// "{:>12}" work without any float-to-decimal conversion.
+template <>
+struct fmt::formatter<Price> : fmt::formatter<std::string_view> {
+  template <typename FormatContext>
+  auto format(const Price& price, FormatContext& ctx) const {
+    char buffer[Price::MAX_CHARS];
+    char* end = price.formatTo(buffer);
+    return fmt::formatter<std::string_view>::format(
+        std::string_view(buffer, static_cast<std::size_t>(end - buffer)), ctx);
+  }
+};
+
+#endif  // PRICE_H
@@ -0,0 +1,56 @@
+#ifndef PROVIDER_SET_H
+#define PROVIDER_SET_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "snapshot.h"
+#include "taskPool.h"
+#include "ticker.h"
+#include "tickerDecoder.h"
+
+// One or more ticker endpoints polled together. Each tick every provider
+// fetches and decodes as its own task on the pool; the results are merged
+// with earlier URLs taking precedence and later ones only adding symbols
+// the earlier ones lack. A single provider runs inline, without the pool.
+// Every URL is read as the same kind of ticker (one asset and schema).
+class ProviderSet {
+ public:
+  ProviderSet(const std::vector<std::string>& urls, TaskPool& pool,
+              const TickerKind& kind);
+
+  std::size_t size() const { return this->providers.size(); }
+  TickerClient& primary() { return *this->providers.front()->ticker; }
+  const TickerClient& primary() const {
+    return *this->providers.front()->ticker;
+  }
+
+  void setMaxBody(std::size_t bytes);
+
+  // Throws only if every provider failed; otherwise the failures of this
+  // tick are left in errors().
+  void fetchSnapshot(const TickerDecoder& decoder, Snapshot& out);
+  const std::vector<std::string>& errors() const { return this->failures; }
+  // Stage times of the slowest provider of the last tick, which is what
+  // the merged snapshot waited for.
+  TickerClient::StageTimes lastStageTimes() const { return this->slowest; }
+
+ private:
+  struct Provider {
+    Provider(const std::string& url, const TickerKind& kind)
+        : url(url), ticker(kind.create(url)) {}
+    std::string url;
+    std::unique_ptr<TickerClient> ticker;
+    Snapshot scratch;  // reused every tick
+    std::string error;
+  };
+
+  std::vector<std::unique_ptr<Provider>> providers;
+  TaskPool& pool;
+  std::vector<std::string> failures;
+  TickerClient::StageTimes slowest;
+};
+
+#endif  // PROVIDER_SET_H
@@ -0,0 +1,187 @@
+#ifndef RCU_CELL_H
+#define RCU_CELL_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Latest version of a T, published by one writer and read by many threads
+// without locks or reference counts (read-copy-update with epoch-based
+// reclamation).
+//
+// Each reader owns a cache-line-sized slot. A read announces the current
+// epoch in that slot and loads the current pointer: two atomic operations,
+// no loop, nothing written that another thread reads in its fast path, so
+// reads are wait-free and scale with the number of cores. The writer fills
+// a draft(), publish() swaps it in and stamps the replaced version with
+// the epoch it retired in; a retired version is reused as a later draft
+// once no slot announces an epoch that old, so a steady-state writer
+// allocates nothing and a reader never sees a version change under it.
+//
+// draft() and publish() belong to one writer thread at a time. A Reader
+// belongs to one thread and holds at most one Guard at a time.
+template <class T>
+class RcuCell {
+  struct Node {
+    T value{};
+    std::uint64_t version = 0;
+    std::uint64_t retiredAt = 0;
+  };
+  struct alignas(64) Slot {
+    std::atomic<std::uint64_t> epoch{IDLE};
+    std::atomic<bool> claimed{false};
+  };
+  static constexpr std::uint64_t IDLE =
+      std::numeric_limits<std::uint64_t>::max();
+
+ public:
+  // The value of one read; the version stays valid until the guard goes.
+  class Guard {
+   public:
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+    Guard(Guard&& other) noexcept
+        : slot(std::exchange(other.slot, nullptr)), node(other.node) {}
+    ~Guard() {
+      if (this->slot) this->slot->epoch.store(IDLE, std::memory_order_release);
+    }
+
+    // Null before the first publish().
+    const T* get() const { return this->node ? &this->node->value : nullptr; }
+    const T& operator*() const { return this->node->value; }
+    const T* operator->() const { return &this->node->value; }
+    explicit operator bool() const { return this->node != nullptr; }
+    std::uint64_t version() const {
+      return this->node ? this->node->version : 0;
+    }
+
+   private:
+    friend class RcuCell;
+    Guard(Slot* slot, const Node* node) : slot(slot), node(node) {}
+    Slot* slot;
+    const Node* node;
+  };
+
+  // One reader thread's registration; frees its slot when destroyed.
+  class Reader {
+   public:
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    Reader(Reader&& other) noexcept
+        : cell(other.cell), slot(std::exchange(other.slot, nullptr)) {}
+    ~Reader() {
+      if (this->slot) {
+        this->slot->claimed.store(false, std::memory_order_release);
+      }
+    }
+
+    Guard read() const {
+      // seq_cst on the announce and the load: a writer that retires a
+      // version after this epoch was read either sees the announcement in
+      // its scan or published before the load here (so it is not seen).
+      const std::uint64_t epoch =
+          this->cell->epoch.load(std::memory_order_seq_cst);
+      this->slot->epoch.store(epoch, std::memory_order_seq_cst);
+      return Guard(this->slot,
+                   this->cell->current.load(std::memory_order_seq_cst));
+    }
+
+   private:
+    friend class RcuCell;
+    Reader(const RcuCell* cell, Slot* slot) : cell(cell), slot(slot) {}
+    const RcuCell* cell;
+    Slot* slot;
+  };
+
+  explicit RcuCell(std::size_t maxReaders = 64)
+      : slotCount(maxReaders), slots(std::make_unique<Slot[]>(maxReaders)) {}
+  RcuCell(const RcuCell&) = delete;
+  RcuCell& operator=(const RcuCell&) = delete;
+  // Readers and guards must be gone by now.
+  ~RcuCell() { delete this->current.load(std::memory_order_relaxed); }
+
+  // Any thread. Throws std::runtime_error once maxReaders are registered.
+  Reader reader() {
+    for (std::size_t i = 0; i < this->slotCount; ++i) {
+      bool expected = false;
+      if (this->slots[i].claimed.compare_exchange_strong(
+              expected, true, std::memory_order_acq_rel)) {
+        return Reader(this, &this->slots[i]);
+      }
+    }
+    throw std::runtime_error("RcuCell: all " +
+                             std::to_string(this->slotCount) +
+                             " reader slots are in use");
+  }
+
+  // Writer only. The value to fill in for the next publish(); a reused
+  // version still holds whatever it held, so overwrite all of it.
+  T& draft() {
+    if (!this->next) {
+      if (this->spare.empty()) this->reclaim();
+      if (this->spare.empty()) {
+        this->next = std::make_unique<Node>();
+      } else {
+        this->next = std::move(this->spare.back());
+        this->spare.pop_back();
+      }
+    }
+    return this->next->value;
+  }
+
+  // Writer only. Makes the draft the current version; returns its number.
+  std::uint64_t publish() {
+    this->draft();
+    this->next->version = ++this->published;
+    Node* old = this->current.exchange(this->next.release(),
+                                       std::memory_order_seq_cst);
+    if (old) {
+      old->retiredAt = this->epoch.fetch_add(1, std::memory_order_seq_cst);
+      this->retired.emplace_back(old);
+    }
+    this->reclaim();
+    return this->published;
+  }
+
+  // Writer only. Versions retired but still possibly being read.
+  std::size_t pending() const { return this->retired.size(); }
+
+ private:
+  // Moves every retired version older than the oldest announced epoch to
+  // the spare list.
+  void reclaim() {
+    std::uint64_t oldest = IDLE;
+    for (std::size_t i = 0; i < this->slotCount; ++i) {
+      const std::uint64_t epoch =
+          this->slots[i].epoch.load(std::memory_order_seq_cst);
+      if (epoch < oldest) oldest = epoch;
+    }
+    auto keep = this->retired.begin();
+    for (auto& node : this->retired) {
+      if (node->retiredAt < oldest) {
+        this->spare.push_back(std::move(node));
+      } else {
+        *keep++ = std::move(node);
+      }
+    }
+    this->retired.erase(keep, this->retired.end());
+  }
+
+  std::size_t slotCount;
+  std::unique_ptr<Slot[]> slots;
+  alignas(64) std::atomic<Node*> current{nullptr};
+  std::atomic<std::uint64_t> epoch{0};
+  // Writer-private from here on.
+  alignas(64) std::uint64_t published = 0;
+  std::unique_ptr<Node> next;
+  std::vector<std::unique_ptr<Node>> retired;
+  std::vector<std::unique_ptr<Node>> spare;
+};
+
+#endif  // RCU_CELL_H
@@ -0,0 +1,35 @@
+#ifndef RENDER_H
+#define RENDER_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+
+#include "snapshot.h"
+#include "tickerSchema.h"
+
+// A whole terminal frame is formatted into one buffer and written with a
+// single call. The first 8 KiB live inline; anything beyond comes from the
+// buffer's allocator, normally the tick's arena.
+using FrameBuffer =
+    fmt::basic_memory_buffer<char, 8192, std::pmr::polymorphic_allocator<char>>;
+
+std::string getCurrentTimeString();
+// Local wall-clock time as HH:MM:SS.
+std::string formatClockTime(std::chrono::system_clock::time_point at);
+// Polling interval for display: "250ms", "5s", "1.5s".
+std::string formatInterval(std::chrono::milliseconds interval);
+
+// Appends the live rates table for `data` to `out`. A zero refreshInterval
+// labels the table as fed by a push stream rather than polling; `stale`
+// marks a warm-start frame drawn from the on-disk cache.
+void renderTable(FrameBuffer& out, const Snapshot& data, int updateCount,
+                 std::chrono::milliseconds refreshInterval, bool stale = false,
+                 const AssetInfo& asset = Btc::INFO);
+// Writes the frame to `out` and flushes.
+void writeFrame(const FrameBuffer& frame, std::FILE* out = stdout);
+
+#endif  // RENDER_H
@@ -0,0 +1,68 @@
+#ifndef SHARED_TICKER_H
+#define SHARED_TICKER_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+#include "snapshot.h"
+#include "ticker.h"
+#include "tickerDecoder.h"
+
+// Thread-safe front for a TickerClient, which on its own owns one curl
+// handle and one body buffer and must not be fetched from two threads.
+//
+// get() is single-flight: the first caller with nothing fresh enough
+// becomes the leader and fetches; everyone arriving while that request is
+// in flight waits for it and receives the same decoded snapshot (or the
+// same error) instead of issuing another one. A completed snapshot younger
+// than `maxStaleness` is returned straight away with no request at all
+// (0 = only share in-flight requests).
+//
+// Snapshots are immutable once published and shared by pointer, so a
+// caller may keep one as long as it likes.
+class SharedTicker {
+ public:
+  SharedTicker(TickerClient& ticker, const TickerDecoder& decoder,
+               std::chrono::milliseconds maxStaleness =
+                   std::chrono::milliseconds(0));
+  SharedTicker(const SharedTicker&) = delete;
+  SharedTicker& operator=(const SharedTicker&) = delete;
+
+  // Latest snapshot no older than the staleness window. Rethrows the
+  // leader's exception to every caller that waited on a failed request.
+  std::shared_ptr<const Snapshot> get();
+  // Last published snapshot, however old, without fetching (null before
+  // the first successful fetch).
+  std::shared_ptr<const Snapshot> cached() const;
+
+  void setMaxStaleness(std::chrono::milliseconds window);
+
+  struct Stats {
+    std::uint64_t calls = 0;
+    std::uint64_t fetches = 0;    // requests actually issued
+    std::uint64_t joined = 0;     // calls that waited on another's request
+    std::uint64_t cacheHits = 0;  // calls served inside the window
+    std::uint64_t errors = 0;     // failed requests
+  };
+  Stats stats() const;
+
+ private:
+  TickerClient& ticker;
+  const TickerDecoder& decoder;
+
+  mutable std::mutex lock;
+  std::condition_variable landed;
+  std::chrono::milliseconds maxStaleness;
+  std::shared_ptr<const Snapshot> latest;
+  std::chrono::steady_clock::time_point latestAt{};
+  bool inFlight = false;
+  std::uint64_t flight = 0;  // completed requests, the waiters' wake-up
+  std::exception_ptr flightError;
+  Stats counters;
+};
+
+#endif  // SHARED_TICKER_H
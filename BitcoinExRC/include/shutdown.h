@@ -0,0 +1,22 @@
+#ifndef SHUTDOWN_H
+#define SHUTDOWN_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <cstdint>
+
+// Lets a loop block until its next deadline with a single wait, while a
+// signal handler can still cut the wait short. Backed by a self-pipe on
+// POSIX and an event object on Windows.
+void initShutdownWakeup();
+// Async-signal-safe; wakes any sleepUntilOrShutdown() caller.
+void notifyShutdownWakeup();
+// Returns true once `deadline` is reached, false if woken for shutdown.
+bool sleepUntilOrShutdown(std::chrono::steady_clock::time_point deadline);
+
+enum class WakeReason { Deadline, Readable, Shutdown };
+// Same wait, but also returns as soon as `socket` (a native socket handle,
+// e.g. libcurl's CURLINFO_ACTIVESOCKET) has data to read.
+WakeReason waitReadableOrShutdown(std::intptr_t socket,
+                                  std::chrono::steady_clock::time_point deadline);
+
+#endif  // SHUTDOWN_H
@@ -0,0 +1,54 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "freshness.h"
+#include "price.h"
+
+// One ticker response laid out as struct-of-arrays: index i of every price
+// array belongs to symbols[i]. Keeps the hot loops (cross rates, diffs)
+// running over contiguous fixed-point prices instead of walking the DOM.
+// Storage is allocator-aware so a tick can build its snapshot on a
+// TickArena; copies made to keep a snapshot around use the default heap.
+struct Snapshot {
+  using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+  Snapshot() = default;
+  explicit Snapshot(const allocator_type& alloc)
+      : symbols(alloc), m15(alloc), last(alloc), buy(alloc), sell(alloc) {}
+
+  std::pmr::vector<std::pmr::string> symbols;
+  std::pmr::vector<Price> m15;
+  std::pmr::vector<Price> last;
+  std::pmr::vector<Price> buy;
+  std::pmr::vector<Price> sell;
+  std::chrono::system_clock::time_point fetchedAt{};
+  // How old the prices were when they arrived; unknown for replays.
+  Freshness freshness;
+  // Order-sensitive FNV-1a over the symbols, kept up to date by push(), so
+  // "same symbol set as last tick?" is one compare instead of n.
+  std::uint64_t symbolsHash = EMPTY_SYMBOLS_HASH;
+
+  static constexpr std::uint64_t EMPTY_SYMBOLS_HASH = 14695981039346656037ULL;
+
+  std::size_t size() const { return this->symbols.size(); }
+  bool empty() const { return this->symbols.empty(); }
+  void clear();
+  void reserve(std::size_t n);
+  void push(std::string_view symbol, Price m15, Price last, Price buy,
+            Price sell);
+  std::optional<std::size_t> indexOf(std::string_view symbol) const;
+
+  static Snapshot fromJson(const nlohmann::json& data);
+};
+
+#endif  // SNAPSHOT_H
@@ -0,0 +1,63 @@
+#ifndef SNAPSHOT_CACHE_H
+#define SNAPSHOT_CACHE_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "snapshot.h"
+#include "tickerDecoder.h"
+
+// Last good snapshot on disk, so a new process can draw its first frame
+// from the cache (marked stale) before the network answers.
+//
+// Layout, little-endian: a 32-byte header ("BTCXSNP1", u32 count,
+// u32 record size, i64 fetchedAt in epoch ms, u64 FNV-1a of the records)
+// followed by `count` 48-byte records (u8 symbol length, 15 symbol bytes,
+// i64 cents x4: 15m, last, buy, sell). Writes go to a temporary file that
+// is renamed over the old one, so readers never see a torn file; each
+// writer gets its own temporary, so concurrent --once runs do not clobber
+// each other's half-written file.
+class SnapshotCache {
+ public:
+  static constexpr std::size_t HEADER_BYTES = 32;
+  static constexpr std::size_t RECORD_BYTES = 48;
+  static constexpr std::size_t MAX_SYMBOL = 15;
+
+  explicit SnapshotCache(std::string path);
+  // $XDG_CACHE_HOME or ~/.cache on POSIX, %LOCALAPPDATA% on Windows, plus
+  // bitcoinexrc/last.bin (last-<asset>.bin for other assets); empty if
+  // none of those is set.
+  static std::string defaultPath(std::string_view asset = {});
+
+  const std::string& path() const { return this->file; }
+  // Throws std::runtime_error if the file cannot be written. Reuses the
+  // buffers of the previous save, so one save at a time.
+  void save(const Snapshot& snapshot) const;
+  // Maps the file and decodes the symbols `filter` accepts into `out`.
+  // False if there is no cache or it fails validation.
+  bool load(Snapshot& out, const SymbolFilter& filter = {}) const;
+
+ private:
+  // Kept across saves so a save per tick stays off the heap.
+  struct Scratch {
+    std::vector<unsigned char> bytes;
+    std::string temporary;
+    bool directoryReady = false;
+  };
+
+  std::string file;
+  mutable Scratch scratch;
+};
+
+// Writes `size` bytes to a new, owner-only file beside `path` (uniquely
+// named, never an existing one) and renames it over `path`. `temporary`
+// receives the temporary's name; a caller that saves repeatedly passes the
+// same string so no save allocates. Throws std::runtime_error naming
+// `what` ("snapshot cache").
+void replaceFile(const std::string& path, const unsigned char* data,
+                 std::size_t size, std::string& temporary,
+                 std::string_view what);
+
+#endif  // SNAPSHOT_CACHE_H
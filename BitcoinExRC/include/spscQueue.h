@@ -0,0 +1,230 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+// What a full queue does with a new item.
+enum class OverflowPolicy {
+  Block,       // the producer waits for room (backpressure)
+  DropOldest,  // the producer discards the oldest queued item
+};
+
+// Bounded lock-free ring between one producer thread and one consumer
+// thread. Every slot carries a sequence number (Vyukov's bounded queue), so
+// a drop-oldest producer can evict from the head with the same CAS the
+// consumer uses, without ever touching a slot the consumer is still moving
+// out of. Blocking waits park on C++20 atomic waits instead of spinning.
+template <class T>
+class SpscQueue {
+ public:
+  struct Stats {
+    std::uint64_t pushed = 0;
+    std::uint64_t popped = 0;
+    std::uint64_t dropped = 0;
+    std::size_t maxDepth = 0;
+    std::uint64_t depthSum = 0;  // depth after each push, for the mean
+    std::chrono::nanoseconds blocked{0};  // producer time spent waiting
+  };
+
+  SpscQueue(std::size_t capacity, OverflowPolicy policy)
+      : mask(roundUp(capacity) - 1),
+        slots(std::make_unique<Slot[]>(mask + 1)),
+        policy(policy) {
+    for (std::size_t i = 0; i <= this->mask; ++i) {
+      this->slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  std::size_t capacity() const { return this->mask + 1; }
+  OverflowPolicy overflow() const { return this->policy; }
+
+  // Producer only. False once the queue is closed.
+  bool push(T value) {
+    const std::uint64_t pos = this->tail.load(std::memory_order_relaxed);
+    Slot& slot = this->slots[pos & this->mask];
+    std::chrono::steady_clock::time_point waitStart{};
+    for (;;) {
+      if (this->closed.load(std::memory_order_acquire)) return false;
+      if (slot.seq.load(std::memory_order_acquire) == pos) break;
+      // Full, or the consumer has claimed the slot and is still moving the
+      // item out; in that case the head is already past it.
+      const std::uint64_t head = this->head.load(std::memory_order_acquire);
+      if (pos - head < this->capacity()) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (this->policy == OverflowPolicy::DropOldest) {
+        // One CAS at the exact head: if the consumer wins the race there is
+        // room now and nothing needs dropping.
+        if (this->evict(head)) ++this->counters.dropped;
+        continue;
+      }
+      if (waitStart == std::chrono::steady_clock::time_point{}) {
+        waitStart = std::chrono::steady_clock::now();
+      }
+      const std::uint32_t seen = this->poppedBell.load();
+      this->producerParked.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (this->head.load(std::memory_order_acquire) == head &&
+          !this->closed.load(std::memory_order_acquire)) {
+        this->poppedBell.wait(seen);
+      }
+      this->producerParked.store(false, std::memory_order_relaxed);
+    }
+    if (waitStart != std::chrono::steady_clock::time_point{}) {
+      this->counters.blocked += std::chrono::steady_clock::now() - waitStart;
+    }
+    slot.value = std::move(value);
+    slot.seq.store(pos + 1, std::memory_order_release);
+    this->tail.store(pos + 1, std::memory_order_release);
+    ring(this->pushedBell, this->consumerParked);
+
+    const std::size_t depth = this->depth();
+    ++this->counters.pushed;
+    this->counters.depthSum += depth;
+    if (depth > this->counters.maxDepth) this->counters.maxDepth = depth;
+    return true;
+  }
+
+  // Consumer only. Non-blocking; false if empty.
+  bool tryPop(T& out) {
+    if (!this->claim(out)) return false;
+    this->popped.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Consumer only. Waits for an item; false once closed and drained.
+  bool pop(T& out) {
+    for (;;) {
+      if (this->tryPop(out)) return true;
+      const std::uint32_t seen = this->pushedBell.load();
+      // Announce the wait before the last look, so a push either sees us
+      // parked and rings, or its item is seen here (fences pair with ring).
+      this->consumerParked.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const bool got = this->tryPop(out);
+      if (!got && !this->closed.load(std::memory_order_acquire)) {
+        this->pushedBell.wait(seen);
+      }
+      this->consumerParked.store(false, std::memory_order_relaxed);
+      if (got) return true;
+      if (this->closed.load(std::memory_order_acquire)) {
+        return this->tryPop(out);
+      }
+    }
+  }
+
+  // Wakes both sides; pop() still drains what is queued.
+  void close() {
+    this->closed.store(true, std::memory_order_release);
+    this->pushedBell.fetch_add(1, std::memory_order_release);
+    this->pushedBell.notify_all();
+    this->poppedBell.fetch_add(1, std::memory_order_release);
+    this->poppedBell.notify_all();
+  }
+
+  std::size_t depth() const {
+    const std::uint64_t tail = this->tail.load(std::memory_order_acquire);
+    const std::uint64_t head = this->head.load(std::memory_order_acquire);
+    return tail > head ? static_cast<std::size_t>(tail - head) : 0;
+  }
+
+  // Producer-side counters plus the consumer's pop count. Read them once
+  // both threads are done, or accept slightly stale values.
+  Stats stats() const {
+    Stats s = this->counters;
+    s.popped = this->popped.load(std::memory_order_relaxed);
+    return s;
+  }
+
+ private:
+  static constexpr std::size_t LINE = 64;  // keeps the indexes unshared
+
+  struct Slot {
+    std::atomic<std::uint64_t> seq{0};
+    T value{};
+  };
+
+  static std::size_t roundUp(std::size_t n) {
+    if (n < 2) n = 2;
+    std::size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+  }
+
+  // Consumer side: takes the head item, retrying if an evicting producer
+  // got there first.
+  bool claim(T& out) {
+    std::uint64_t pos = this->head.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& slot = this->slots[pos & this->mask];
+      const std::uint64_t seq = slot.seq.load(std::memory_order_acquire);
+      if (seq < pos + 1) return false;  // empty
+      if (seq == pos + 1 &&
+          this->head.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_relaxed)) {
+        out = std::move(slot.value);
+        this->release(slot, pos);
+        return true;
+      }
+      // Lost the race (or saw a stale head): reload and retry.
+      if (seq != pos + 1) pos = this->head.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Producer side: drops the item at `pos` if it is still the head. The
+  // stale value is released when the next push overwrites the slot.
+  bool evict(std::uint64_t pos) {
+    Slot& slot = this->slots[pos & this->mask];
+    if (slot.seq.load(std::memory_order_acquire) != pos + 1 ||
+        !this->head.compare_exchange_strong(pos, pos + 1,
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)) {
+      return false;
+    }
+    this->release(slot, pos);
+    return true;
+  }
+
+  // Hands the slot to the producer's next lap.
+  void release(Slot& slot, std::uint64_t pos) {
+    slot.seq.store(pos + this->mask + 1, std::memory_order_release);
+    ring(this->poppedBell, this->producerParked);
+  }
+
+  // Wakes the other side only if it announced it is parking: the common,
+  // uncontended case costs a fence instead of a shared RMW and a notify.
+  static void ring(std::atomic<std::uint32_t>& bell,
+                   const std::atomic<bool>& parked) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!parked.load(std::memory_order_relaxed)) return;
+    bell.fetch_add(1, std::memory_order_release);
+    bell.notify_one();
+  }
+
+  const std::size_t mask;
+  std::unique_ptr<Slot[]> slots;
+  const OverflowPolicy policy;
+
+  alignas(LINE) std::atomic<std::uint64_t> head{0};
+  alignas(LINE) std::atomic<std::uint64_t> tail{0};
+  // Bumped after a push/pop when the other side is parked on them.
+  alignas(LINE) std::atomic<std::uint32_t> pushedBell{0};
+  std::atomic<bool> consumerParked{false};
+  alignas(LINE) std::atomic<std::uint32_t> poppedBell{0};
+  std::atomic<bool> producerParked{false};
+  alignas(LINE) std::atomic<std::uint64_t> popped{0};
+  std::atomic<bool> closed{false};
+  Stats counters;  // producer-owned
+};
+
+#endif  // SPSC_QUEUE_H
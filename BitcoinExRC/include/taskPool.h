@@ -0,0 +1,206 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Move-only type-erased `void()` callable, so tasks can own futures'
+// promises (std::function would demand copyable targets). Callables of up
+// to INLINE_BYTES (a lambda with a few captures, a packaged_task) are kept
+// in the Task itself, so posting them costs no heap allocation.
+class Task {
+ public:
+  static constexpr std::size_t INLINE_BYTES = 6 * sizeof(void*);
+
+  Task() = default;
+  template <class F, class = std::enable_if_t<
+                         !std::is_same_v<std::decay_t<F>, Task>>>
+  Task(F&& f) {  // NOLINT(google-explicit-constructor)
+    using Target = std::decay_t<F>;
+    if constexpr (fitsInline<Target>()) {
+      ::new (static_cast<void*>(this->storage)) Target(std::forward<F>(f));
+      this->ops = &InlineOps<Target>::OPS;
+    } else {
+      ::new (static_cast<void*>(this->storage))
+          Target*(new Target(std::forward<F>(f)));
+      this->ops = &HeapOps<Target>::OPS;
+    }
+  }
+  Task(Task&& other) noexcept { this->take(other); }
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      this->reset();
+      this->take(other);
+    }
+    return *this;
+  }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+  ~Task() { this->reset(); }
+
+  void operator()() { this->ops->call(this->storage); }
+  explicit operator bool() const { return this->ops != nullptr; }
+
+ private:
+  struct Ops {
+    void (*call)(void* target);
+    void (*move)(void* from, void* to);  // and destroys `from`
+    void (*destroy)(void* target);
+  };
+  template <class F>
+  static constexpr bool fitsInline() {
+    return sizeof(F) <= INLINE_BYTES &&
+           alignof(F) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible_v<F>;
+  }
+  template <class F>
+  struct InlineOps {
+    static F& target(void* p) { return *std::launder(static_cast<F*>(p)); }
+    static void call(void* p) { target(p)(); }
+    static void move(void* from, void* to) {
+      ::new (to) F(std::move(target(from)));
+      target(from).~F();
+    }
+    static void destroy(void* p) { target(p).~F(); }
+    static constexpr Ops OPS{call, move, destroy};
+  };
+  template <class F>
+  struct HeapOps {
+    static F*& target(void* p) { return *std::launder(static_cast<F**>(p)); }
+    static void call(void* p) { (*target(p))(); }
+    static void move(void* from, void* to) { ::new (to) F*(target(from)); }
+    static void destroy(void* p) { delete target(p); }
+    static constexpr Ops OPS{call, move, destroy};
+  };
+
+  void take(Task& other) noexcept {
+    if (other.ops == nullptr) return;
+    other.ops->move(other.storage, this->storage);
+    this->ops = std::exchange(other.ops, nullptr);
+  }
+  void reset() noexcept {
+    if (this->ops == nullptr) return;
+    this->ops->destroy(this->storage);
+    this->ops = nullptr;
+  }
+
+  const Ops* ops = nullptr;
+  alignas(std::max_align_t) unsigned char storage[INLINE_BYTES];
+};
+
+// Shared executor for short tasks: per-provider fetch/decode and
+// per-consumer processing. Each worker owns a deque; it pushes and pops
+// its own work at the back (LIFO, cache-warm) and, when empty, steals the
+// oldest task from the front of another worker's deque. Tasks submitted
+// from outside the pool are spread round-robin.
+class TaskPool {
+ public:
+  // 0 = one worker per hardware thread.
+  explicit TaskPool(std::size_t workers = 0);
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+  // Runs what is still queued, then joins the workers.
+  ~TaskPool();
+
+  std::size_t size() const { return this->threads.size(); }
+
+  // Fire and forget; an escaping exception is dropped.
+  void post(Task task);
+
+  template <class F>
+  auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>&>> {
+    using Result = std::invoke_result_t<std::decay_t<F>&>;
+    std::packaged_task<Result()> task(std::forward<F>(f));
+    auto future = task.get_future();
+    this->post(Task(std::move(task)));
+    return future;
+  }
+
+  // Runs one queued task on the calling thread, if there is one. Lets a
+  // thread that waits on pool work help instead of blocking a worker.
+  bool runPending();
+
+ private:
+  // Ring of tasks that keeps its capacity, where a std::deque would free
+  // and reallocate blocks as the work drifts through it. Owner pushes and
+  // pops at the back; thieves take from the front.
+  class TaskRing {
+   public:
+    bool empty() const { return this->count == 0; }
+    void pushBack(Task task);
+    Task popBack();
+    Task popFront();
+
+   private:
+    std::vector<Task> slots;
+    std::size_t head = 0;
+    std::size_t count = 0;
+  };
+  struct Queue {
+    std::mutex lock;
+    TaskRing tasks;
+  };
+
+  void workerLoop(std::size_t index);
+  bool tryTake(std::size_t self, Task& out);
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> threads;
+  std::atomic<std::size_t> nextQueue{0};
+  std::atomic<std::size_t> queued{0};
+  std::mutex sleepLock;
+  std::condition_variable wake;
+  bool stopping = false;
+};
+
+// Fork/join scope on a TaskPool. wait() helps run queued tasks until every
+// task of the group is done, then rethrows the first exception one threw.
+class TaskGroup {
+ public:
+  explicit TaskGroup(TaskPool& pool) : pool(pool) {}
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+  ~TaskGroup();
+
+  template <class F>
+  void run(F&& f) {
+    {
+      std::lock_guard<std::mutex> guard(this->lock);
+      ++this->pending;
+    }
+    this->pool.post([this, f = std::forward<F>(f)]() mutable {
+      std::exception_ptr thrown;
+      try {
+        f();
+      } catch (...) {
+        thrown = std::current_exception();
+      }
+      // Notified under the lock: wait() can only see the count reach zero
+      // after this task is done touching the group, which it may then free.
+      std::lock_guard<std::mutex> guard(this->lock);
+      if (thrown && !this->error) this->error = std::move(thrown);
+      if (--this->pending == 0) this->done.notify_all();
+    });
+  }
+
+  void wait();
+
+ private:
+  TaskPool& pool;
+  std::mutex lock;
+  std::condition_variable done;
+  std::size_t pending = 0;  // guarded by lock
+  std::exception_ptr error;  // first exception a task threw; guarded by lock
+};
+
+#endif  // TASK_POOL_H
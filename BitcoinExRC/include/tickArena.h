@@ -0,0 +1,33 @@
+#ifndef TICK_ARENA_H
+#define TICK_ARENA_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+// Per-tick bump allocator. Everything a frame needs (decoded snapshot,
+// formatted output) is carved out of one preallocated block and released
+// wholesale by reset(), so steady-state ticks never touch the global heap.
+// Only an oversized frame spills over to the upstream (global) resource.
+class TickArena {
+ public:
+  static constexpr std::size_t DEFAULT_BYTES = 256 * 1024;
+
+  explicit TickArena(std::size_t bytes = DEFAULT_BYTES);
+  TickArena(const TickArena&) = delete;
+  TickArena& operator=(const TickArena&) = delete;
+
+  std::pmr::memory_resource* resource() { return &this->arena; }
+  std::pmr::polymorphic_allocator<std::byte> allocator() {
+    return std::pmr::polymorphic_allocator<std::byte>(&this->arena);
+  }
+  // Frees everything allocated since the last reset. Objects built on the
+  // arena must be gone by then.
+  void reset() { this->arena.release(); }
+
+ private:
+  std::unique_ptr<std::byte[]> storage;
+  std::pmr::monotonic_buffer_resource arena;
+};
+
+#endif  // TICK_ARENA_H
@@ -0,0 +1,52 @@
+#ifndef TICK_SCHEDULER_H
+#define TICK_SCHEDULER_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+#include "latencyHistogram.h"
+
+// Fixed-rate ticks on absolute steady_clock (CLOCK_MONOTONIC) deadlines:
+// tick n is due at start + n * interval no matter how long the work in
+// between took, so the period does not drift. Deadlines a slow tick ran
+// past are skipped rather than fired back to back. With `alignToWallClock`
+// the deadlines are phased so ticks land on multiples of the interval in
+// wall-clock time (every :00, :05 ... for 5s).
+class TickScheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit TickScheduler(std::chrono::nanoseconds interval,
+                         bool alignToWallClock = false);
+
+  // Advances to the next deadline that is still in the future.
+  Clock::time_point next();
+  Clock::time_point deadline() const { return this->due; }
+  // Sleeps until deadline() and records how late the wakeup was in
+  // jitter(). Returns false if shutdown was requested instead.
+  bool wait();
+  bool waitNext() {
+    this->next();
+    return this->wait();
+  }
+
+  std::chrono::nanoseconds interval() const { return this->period; }
+  std::uint64_t skipped() const { return this->missed; }
+  const LatencyHistogram& jitter() const { return this->lateness; }
+
+  static constexpr std::chrono::milliseconds MAX_INTERVAL =
+      std::chrono::hours(24);
+
+  // "250ms", "2s", "1.5s"; a bare number is seconds. Throws
+  // std::invalid_argument below 1ms or above MAX_INTERVAL.
+  static std::chrono::milliseconds parseInterval(std::string_view text);
+
+ private:
+  std::chrono::nanoseconds period;
+  Clock::time_point due;
+  std::uint64_t missed = 0;
+  LatencyHistogram lateness;
+};
+
+#endif  // TICK_SCHEDULER_H
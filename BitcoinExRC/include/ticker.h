@@ -0,0 +1,143 @@
+#ifndef TICKER_H
+#define TICKER_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "curlHandler.h"
+#include "dnsPrefetch.h"
+#include "snapshot.h"
+#include "tickerDecoder.h"
+#include "tickerSchema.h"
+
+// HTTP side of a ticker endpoint: transfer, validation and timings. What
+// the payload means is left to Ticker<Asset, Provider>, so code that only
+// drives fetches (ProviderSet, Pipeline) works with any asset.
+// One client is one curl handle and body buffer: fetch from one thread at
+// a time, or share it between threads through a SharedTicker.
+class TickerClient {
+  using json = nlohmann::json;
+
+ public:
+  explicit TickerClient(const std::string& url);
+  TickerClient(const TickerClient&) = delete;
+  TickerClient& operator=(const TickerClient&) = delete;
+  virtual ~TickerClient() = default;
+
+  json fetch();
+  // Fetches and decodes straight into a Snapshot, skipping symbols the
+  // decoder's filter rejects without building a DOM.
+  Snapshot fetchSnapshot(const TickerDecoder& decoder);
+  // Same, decoding into `out` so the caller controls its allocator.
+  void fetchSnapshot(const TickerDecoder& decoder, Snapshot& out);
+  // Fetches only; the raw body is validated and decoded elsewhere (the
+  // pipeline's decode stage).
+  std::string fetchPayload();
+  // Decodes a validated payload with this provider's field schema.
+  virtual void decode(const TickerDecoder& decoder, std::string_view json,
+                      Snapshot& out) const = 0;
+  virtual AssetInfo asset() const = 0;
+
+  // Skips curl's own DNS lookup using an address resolved ahead of time.
+  void pinAddress(const ResolvedAddress& resolved);
+  // TLS sessions to carry over to the next process (ConnectionCache).
+  std::vector<TlsSession> exportTlsSessions() const {
+    return this->curlHandle.exportTlsSessions();
+  }
+  std::size_t importTlsSessions(const std::vector<TlsSession>& sessions) {
+    return this->curlHandle.importTlsSessions(sessions);
+  }
+  // Response size cap (see CurlHandler::setMaxBody); 0 = none.
+  void setMaxBody(std::size_t bytes) { this->curlHandle.setMaxBody(bytes); }
+  // Gives a fetchPayload() body back for reuse once it has been decoded.
+  static void recycle(std::string&& payload) {
+    CurlHandler::recycle(std::move(payload));
+  }
+  TransferTimings lastTimings() const { return this->curlHandle.timings(); }
+  // Server clock skew and data age of the last response.
+  Freshness lastFreshness() const { return this->curlHandle.freshness(); }
+  // Wall time the last fetch spent on the transfer and on decoding.
+  struct StageTimes {
+    std::chrono::nanoseconds fetch{0};
+    std::chrono::nanoseconds decode{0};
+  };
+  StageTimes lastStageTimes() const { return this->stageTimes; }
+
+  // Helper function for JSON validation and cleaning. Returns a trimmed
+  // view into rawData rather than a copy.
+  static std::string_view validateAndCleanJson(std::string_view rawData);
+
+ private:
+  CurlHandler curlHandle;
+  StageTimes stageTimes;
+};
+
+// Providers: where a ticker lives and the compile-time schema of its
+// per-symbol objects. A new one needs a TickerKind entry to be selectable.
+struct BlockchainInfo {
+  static constexpr const char* DEFAULT_URL = "https://blockchain.info/ticker";
+  using Schema = FieldSchema<FieldKey<"15m", PriceField::M15>,
+                             FieldKey<"last", PriceField::Last>,
+                             FieldKey<"buy", PriceField::Buy>,
+                             FieldKey<"sell", PriceField::Sell>>;
+};
+
+// Example second provider: ETH quotes as {"price","bid","ask","open_15m"},
+// as served by tools/standin_server.py at /eth/ticker. It has no public
+// endpoint, so there is no default: --url is required.
+struct EtherFeed {
+  static constexpr const char* DEFAULT_URL = nullptr;
+  using Schema = FieldSchema<FieldKey<"open_15m", PriceField::M15>,
+                             FieldKey<"price", PriceField::Last>,
+                             FieldKey<"bid", PriceField::Buy>,
+                             FieldKey<"ask", PriceField::Sell>>;
+};
+
+// `Asset` priced by `Provider`. The decode path is specialized for the
+// provider's schema at compile time; only the per-tick decode() call
+// itself goes through the vtable.
+template <class Asset, class Provider>
+class Ticker final : public TickerClient {
+ public:
+  using AssetType = Asset;
+  using ProviderType = Provider;
+  static constexpr const char* DEFAULT_URL = Provider::DEFAULT_URL;
+
+  Ticker()
+    requires(Provider::DEFAULT_URL != nullptr)
+      : Ticker(DEFAULT_URL) {}
+  explicit Ticker(const std::string& url) : TickerClient(url) {}
+
+  void decode(const TickerDecoder& decoder, std::string_view json,
+              Snapshot& out) const override {
+    decoder.decodeAs<typename Provider::Schema>(json, out);
+  }
+  AssetInfo asset() const override { return Asset::INFO; }
+};
+
+using EtherTicker = Ticker<Eth, EtherFeed>;
+
+// The tickers --asset can select, by name.
+struct TickerKind {
+  const char* name;
+  AssetInfo asset;
+  const char* defaultUrl;  // nullptr: --url is required
+  std::unique_ptr<TickerClient> (*create)(const std::string& url);
+  // Decodes without a client, for recorded payloads (--replay).
+  void (*decode)(const TickerDecoder& decoder, std::string_view json,
+                 Snapshot& out);
+
+  // Throws std::invalid_argument for an unknown name.
+  static const TickerKind& find(std::string_view name);
+  // "btc, eth", for help and error text.
+  static std::string names();
+};
+
+#endif  // TICKER_H
@@ -0,0 +1,68 @@
+#ifndef TICKER_DECODER_H
+#define TICKER_DECODER_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "snapshot.h"
+
+// Set of symbols a caller cares about. An empty filter accepts everything.
+class SymbolFilter {
+ public:
+  SymbolFilter() = default;
+  explicit SymbolFilter(std::vector<std::string> symbols);
+
+  bool acceptsAll() const { return this->symbols.empty(); }
+  // One hash lookup, however long the --symbols list.
+  bool accepts(std::string_view symbol) const;
+  std::size_t size() const { return this->symbols.size(); }
+
+ private:
+  // Transparent, so payload keys are looked up without a std::string each.
+  // Inline FNV-1a: keys are a few bytes, too short to amortize a call.
+  struct SymbolHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view symbol) const {
+      std::uint64_t hash = 14695981039346656037ULL;
+      for (char c : symbol) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+      }
+      return static_cast<std::size_t>(hash);
+    }
+  };
+
+  std::unordered_set<std::string, SymbolHash, std::equal_to<>> symbols;
+};
+
+// Decodes a `{symbol: {field: price, ...}, ...}` ticker payload straight
+// into a Snapshot without building a DOM. Objects of symbols rejected by
+// the filter are skipped by brace matching that only visits quotes and
+// brackets, so neither their keys nor their numbers are materialized and
+// the cost follows the selection, not the payload.
+class TickerDecoder {
+ public:
+  explicit TickerDecoder(SymbolFilter filter = {});
+
+  // blockchain.info field names.
+  Snapshot decode(std::string_view json) const;
+  // Decodes into an existing snapshot, reusing its storage.
+  void decode(std::string_view json, Snapshot& out) const;
+  // Same, with the field names of a provider's FieldSchema (see
+  // tickerSchema.h). Defined in tickerDecoder.inl.
+  template <class Schema>
+  void decodeAs(std::string_view json, Snapshot& out) const;
+
+  const SymbolFilter& symbolFilter() const { return this->filter; }
+
+ private:
+  SymbolFilter filter;
+};
+
+#include "tickerDecoder.inl"
+
+#endif  // TICKER_DECODER_H
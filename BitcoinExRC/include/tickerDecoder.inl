@@ -0,0 +1,171 @@
+#ifndef TICKER_DECODER_INL
+#define TICKER_DECODER_INL
+// Copyright(c)2022 Vishal Ahirwar.
+// TickerDecoder::decodeAs, included by tickerDecoder.h so that any
+// FieldSchema can be decoded without an instantiation in the library.
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "tickerSchema.h"
+#include "trace.h"
+
+namespace tickerDecoderDetail {
+// Offset just past the object or array that opens at text[pos], or npos if
+// it is not closed. Jumps from quote to bracket to quote instead of
+// looking at every byte (tickerDecoder.cc).
+std::size_t skipComposite(std::string_view text, std::size_t pos);
+
+// Position in a ticker payload; fail() throws with the byte offset.
+class Cursor {
+ public:
+  explicit Cursor(std::string_view text) : text(text) {}
+
+  [[noreturn]] void fail(const char* what) const {
+    throw std::runtime_error("Ticker decode failed at byte " +
+                             std::to_string(this->pos) + ": " + what);
+  }
+
+  void skipWhitespace() {
+    while (this->pos < this->text.size()) {
+      char c = this->text[this->pos];
+      if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+      ++this->pos;
+    }
+  }
+
+  // Consumes `c` (after whitespace) if present.
+  bool consume(char c) {
+    this->skipWhitespace();
+    if (this->pos < this->text.size() && this->text[this->pos] == c) {
+      ++this->pos;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c, const char* what) {
+    if (!this->consume(c)) this->fail(what);
+  }
+
+  // Returns the raw bytes between the quotes. Escapes are skipped over but
+  // not decoded; ticker keys are plain ASCII currency codes.
+  std::string_view string() {
+    this->expect('"', "expected string");
+    const std::size_t start = this->pos;
+    const char* data = this->text.data();
+    while (this->pos < this->text.size()) {
+      const void* quote =
+          std::memchr(data + this->pos, '"', this->text.size() - this->pos);
+      if (quote == nullptr) break;
+      std::size_t end = static_cast<const char*>(quote) - data;
+      // A quote preceded by an odd run of backslashes is escaped.
+      std::size_t slashes = 0;
+      while (end - slashes > start && data[end - slashes - 1] == '\\') {
+        ++slashes;
+      }
+      this->pos = end + 1;
+      if (slashes % 2 == 0) return this->text.substr(start, end - start);
+    }
+    this->pos = this->text.size();
+    this->fail("unterminated string");
+  }
+
+  // Single pass over the digits straight into fixed point.
+  Price number() {
+    this->skipWhitespace();
+    const char* first = this->text.data() + this->pos;
+    Price value;
+    auto [ptr, ec] =
+        Price::fromChars(first, this->text.data() + this->text.size(), value);
+    if (ec != std::errc{}) this->fail("invalid price");
+    this->pos += static_cast<std::size_t>(ptr - first);
+    return value;
+  }
+
+  // Skips one JSON value of any type without interpreting it.
+  void skipValue() {
+    this->skipWhitespace();
+    if (this->pos >= this->text.size()) this->fail("unexpected end of input");
+    const char c = this->text[this->pos];
+    if (c == '"') {
+      this->string();
+      return;
+    }
+    if (c != '{' && c != '[') {
+      while (this->pos < this->text.size() &&
+             std::strchr(",}] \t\r\n", this->text[this->pos]) == nullptr) {
+        ++this->pos;
+      }
+      return;
+    }
+    const std::size_t end = skipComposite(this->text, this->pos);
+    if (end == std::string_view::npos) {
+      this->pos = this->text.size();
+      this->fail("unterminated object");
+    }
+    this->pos = end;
+  }
+
+  bool atEnd() {
+    this->skipWhitespace();
+    return this->pos >= this->text.size();
+  }
+
+ private:
+  std::string_view text;
+  std::size_t pos = 0;
+};
+}  // namespace tickerDecoderDetail
+
+template <class Schema>
+void TickerDecoder::decodeAs(std::string_view json, Snapshot& out) const {
+  TRACE_SPAN("parse");
+  out.clear();
+  tickerDecoderDetail::Cursor cursor(json);
+  cursor.expect('{', "expected '{' at start of ticker");
+  if (!cursor.consume('}')) {
+    do {
+      std::string_view symbol = cursor.string();
+      cursor.expect(':', "expected ':' after symbol");
+      if (!this->filter.accepts(symbol)) {
+        cursor.skipValue();
+        continue;
+      }
+      Price prices[4];
+      unsigned seen = 0;
+      cursor.expect('{', "expected object for symbol");
+      if (!cursor.consume('}')) {
+        do {
+          std::string_view field = cursor.string();
+          cursor.expect(':', "expected ':' after field");
+          const int index = Schema::lookup(field);
+          if (index >= 0) {
+            prices[index] = cursor.number();
+            seen |= 1U << index;
+          } else {
+            cursor.skipValue();
+          }
+        } while (cursor.consume(','));
+        cursor.expect('}', "expected '}' after symbol fields");
+      }
+      if (seen != Schema::MASK) {
+        throw std::runtime_error("Ticker decode failed: symbol " +
+                                 std::string(symbol) +
+                                 " is missing a price field");
+      }
+      out.push(symbol, prices[static_cast<int>(PriceField::M15)],
+               prices[static_cast<int>(PriceField::Last)],
+               prices[static_cast<int>(PriceField::Buy)],
+               prices[static_cast<int>(PriceField::Sell)]);
+    } while (cursor.consume(','));
+    cursor.expect('}', "expected '}' at end of ticker");
+  }
+  if (!cursor.atEnd()) cursor.fail("trailing data after ticker");
+  out.fetchedAt = std::chrono::system_clock::now();
+}
+
+#endif  // TICKER_DECODER_INL
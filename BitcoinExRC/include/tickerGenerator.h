@@ -0,0 +1,19 @@
+#ifndef TICKER_GENERATOR_H
+#define TICKER_GENERATOR_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Ticker-shaped JSON for benchmarks, replay files and load tests, laid out
+// like blockchain.info's payload but with any number of symbols.
+
+// Distinct uppercase code for every index: AAA..ZZZ first, then AAAA..ZZZZ
+// and so on, so small tickers keep three-letter symbols.
+std::string syntheticSymbol(std::size_t index);
+
+// `symbols` entries with deterministic prices. Tick 0 is the base payload;
+// other ticks move every price a little, so consecutive ticks differ.
+std::string syntheticTicker(std::size_t symbols, std::uint64_t tick = 0);
+
+#endif  // TICKER_GENERATOR_H
@@ -0,0 +1,73 @@
+#ifndef TICKER_POLLER_H
+#define TICKER_POLLER_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "rcuCell.h"
+#include "snapshot.h"
+#include "ticker.h"
+#include "tickerDecoder.h"
+
+// Background polling for programs that embed the library: a thread of its
+// own fetches on the TickScheduler cadence and publishes each snapshot
+// through an RcuCell, so any number of reader threads get the latest
+// prices wait-free while the next one is being fetched.
+//
+//   TickerPoller poller(ticker, decoder, std::chrono::seconds(1));
+//   poller.start();
+//   auto reader = poller.reader();  // once per thread
+//   if (auto prices = reader.read()) use(prices->last);
+//
+// A failed fetch keeps the previous snapshot published and is counted in
+// stats(); the poller carries on at the next tick.
+class TickerPoller {
+ public:
+  using Cell = RcuCell<Snapshot>;
+
+  TickerPoller(TickerClient& ticker, const TickerDecoder& decoder,
+               std::chrono::milliseconds interval,
+               bool alignToWallClock = false, std::size_t maxReaders = 64);
+  TickerPoller(const TickerPoller&) = delete;
+  TickerPoller& operator=(const TickerPoller&) = delete;
+  // Stops the thread; readers must be released before the poller goes.
+  ~TickerPoller();
+
+  void start();
+  // Finishes the fetch in progress, if any, then joins the thread.
+  void stop();
+
+  Cell::Reader reader() { return this->cell.reader(); }
+  // Waits for the first snapshot; false if `timeout` passed first.
+  bool waitForFirst(std::chrono::milliseconds timeout);
+
+  struct Stats {
+    std::uint64_t published = 0;
+    std::uint64_t errors = 0;
+  };
+  Stats stats() const;
+  std::string lastError() const;
+
+ private:
+  void run();
+
+  TickerClient& ticker;
+  const TickerDecoder& decoder;
+  std::chrono::milliseconds interval;
+  bool alignToWallClock;
+  Cell cell;
+
+  std::thread thread;
+  mutable std::mutex lock;
+  std::condition_variable wake;
+  bool stopping = false;
+  Stats counters;
+  std::string error;
+};
+
+#endif  // TICKER_POLLER_H
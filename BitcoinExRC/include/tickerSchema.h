@@ -0,0 +1,66 @@
+#ifndef TICKER_SCHEMA_H
+#define TICKER_SCHEMA_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Display identity of what a ticker prices.
+struct AssetInfo {
+  std::string_view code;  // "BTC"
+  std::string_view name;  // "Bitcoin"
+};
+
+struct Btc {
+  static constexpr AssetInfo INFO{"BTC", "Bitcoin"};
+};
+
+struct Eth {
+  static constexpr AssetInfo INFO{"ETH", "Ethereum"};
+};
+
+// The four prices a Snapshot keeps per symbol.
+enum class PriceField : std::uint8_t { M15, Last, Buy, Sell };
+
+// String literal usable as a template argument: FieldKey<"last", ...>.
+template <std::size_t N>
+struct FixedString {
+  constexpr FixedString(const char (&text)[N]) {  // NOLINT
+    std::copy_n(text, N, this->chars);
+  }
+  constexpr std::string_view view() const { return {this->chars, N - 1}; }
+
+  char chars[N] = {};
+};
+
+// One JSON key of a provider's per-symbol object and the price it holds.
+template <FixedString Key, PriceField Field>
+struct FieldKey {
+  static constexpr std::string_view KEY = Key.view();
+  static constexpr PriceField FIELD = Field;
+};
+
+// A provider's per-symbol field layout, fixed at compile time. lookup()
+// unrolls into one length check and compare per key against constants,
+// so a decoder instantiated for the schema does no map or table lookup.
+// Every PriceField must be mapped exactly once.
+template <class... Keys>
+struct FieldSchema {
+  static constexpr unsigned MASK =
+      (0U | ... | (1U << static_cast<unsigned>(Keys::FIELD)));
+  static_assert(sizeof...(Keys) == 4 && MASK == 15,
+                "a field schema maps each PriceField exactly once");
+
+  // Index of the PriceField `key` holds, or -1 for keys the schema skips.
+  static constexpr int lookup(std::string_view key) {
+    int field = -1;
+    static_cast<void>(
+        ((key == Keys::KEY ? (field = static_cast<int>(Keys::FIELD), true)
+                           : false) ||
+         ...));
+    return field;
+  }
+};
+
+#endif  // TICKER_SCHEMA_H
@@ -0,0 +1,78 @@
+#ifndef TICKER_STREAM_H
+#define TICKER_STREAM_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "curlHandler.h"
+#include "snapshot.h"
+#include "tickerDecoder.h"
+
+// Push-based alternative to polling BitCoin: keeps one WebSocket
+// subscription open and applies price updates to a Snapshot as they
+// arrive, so staleness is one network hop rather than the poll interval.
+//
+// Wire protocol, one JSON text frame per message (tools/standin_server.py
+// implements the server side):
+//   -> {"op":"subscribe","since":N}
+//   <- {"type":"snapshot","seq":N,"sent":US,"ticker":{...}}
+//   <- {"type":"update","seq":N,"sent":US,"ticker":{...}}
+// "ticker" uses the REST ticker schema; updates carry only the symbols that
+// changed and consecutive seqs. "sent" is the server's epoch time in
+// microseconds. After a drop or a seq gap the stream resubscribes with the
+// last seq it applied, and the server either replays the missed updates or
+// starts over with a snapshot.
+class TickerStream {
+ public:
+  struct Stats {
+    std::uint64_t messages = 0;
+    std::uint64_t snapshots = 0;
+    std::uint64_t reconnects = 0;
+    std::uint64_t gaps = 0;
+    // Server "sent" stamp to applied, in microseconds. Only meaningful when
+    // the server shares our clock, i.e. the local stand-in.
+    std::uint64_t latencySamples = 0;
+    double latencyMinUs = 0;
+    double latencyMaxUs = 0;
+    double latencySumUs = 0;
+  };
+
+  TickerStream(std::string url, const TickerDecoder& decoder);
+
+  // Applies every message that arrives before `deadline` and returns as
+  // soon as at least one changed `snapshot`, with the number that did;
+  // returns 0 on timeout or shutdown.
+  // Connection failures throw after scheduling a resumed reconnect with
+  // exponential backoff, so the caller can report and call again.
+  std::size_t waitForUpdates(Snapshot& snapshot,
+                             std::chrono::steady_clock::time_point deadline);
+
+  bool connected() const { return this->handle != nullptr; }
+  std::uint64_t lastSeq() const { return this->seq; }
+  const Stats& stats() const { return this->counters; }
+
+ private:
+  void connect();
+  void disconnect(std::chrono::milliseconds retryIn);
+  void send(std::string_view text);
+  // Reads whatever is buffered; true once `message` holds a whole frame.
+  bool receive();
+  // True if the message changed `snapshot`.
+  bool apply(std::string_view message, Snapshot& snapshot);
+
+  std::string url;
+  const TickerDecoder& decoder;
+  curl_ptr handle{nullptr, CurlHandler::deleter};
+  std::intptr_t socket = -1;
+  std::string message;
+  Snapshot scratch;
+  std::uint64_t seq = 0;
+  unsigned failures = 0;
+  std::chrono::steady_clock::time_point retryAt{};
+  Stats counters;
+};
+
+#endif  // TICKER_STREAM_H
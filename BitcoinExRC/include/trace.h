@@ -0,0 +1,97 @@
+#ifndef TRACE_H
+#define TRACE_H
+// Copyright(c)2022 Vishal Ahirwar.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if defined(BITCOINEXRC_TRACING) && \
+    (defined(__x86_64__) || defined(_M_X64) || defined(__i386__))
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define BITCOINEXRC_TRACE_TSC 1
+#endif
+
+// Scoped timeline spans for --trace. Each thread appends finished spans to
+// its own fixed-size ring (oldest overwritten), so recording takes no lock
+// and allocates nothing after a thread's first span; Tracer::write() dumps
+// every ring as Chrome trace-event JSON for Perfetto / chrome://tracing.
+//
+// Built only with -DENABLE_TRACING=ON (the default). Without it
+// TRACE_SPAN() expands to nothing and Tracer::available() is false.
+//
+// Span names must be string literals: only the pointer is stored.
+#ifdef BITCOINEXRC_TRACING
+
+class Tracer {
+ public:
+  static constexpr bool available() { return true; }
+  // Spans are recorded from the first start() on.
+  static void start();
+  static bool enabled() { return active.load(std::memory_order_relaxed); }
+  // Label for the calling thread's track in the timeline.
+  static void nameThread(const char* name);
+  // Raw span timestamp: the TSC on x86 (half the cost of steady_clock,
+  // which matters at two reads per span), steady_clock nanoseconds
+  // elsewhere. write() converts to time using a calibration taken at
+  // start() and again at write().
+  static std::uint64_t now() {
+#ifdef BITCOINEXRC_TRACE_TSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+  }
+  static void record(const char* name, std::uint64_t start,
+                     std::uint64_t end);
+  // Returns the number of spans written; throws std::runtime_error if
+  // the file cannot be written.
+  static std::size_t write(const std::string& path);
+
+ private:
+  static std::atomic<bool> active;
+};
+
+class TraceSpan {
+ public:
+  explicit TraceSpan(const char* name)
+      : name(Tracer::enabled() ? name : nullptr),
+        start(this->name ? Tracer::now() : 0) {}
+  ~TraceSpan() {
+    if (this->name) Tracer::record(this->name, this->start, Tracer::now());
+  }
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  const char* name;
+  std::uint64_t start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+#else
+
+class Tracer {
+ public:
+  static constexpr bool available() { return false; }
+  static void start() {}
+  static constexpr bool enabled() { return false; }
+  static void nameThread(const char*) {}
+  static std::size_t write(const std::string&) { return 0; }
+};
+
+#define TRACE_SPAN(name) static_cast<void>(0)
+
+#endif  // BITCOINEXRC_TRACING
+
+#endif  // TRACE_H
@@ -0,0 +1,257 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/alerts.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+std::chrono::seconds parseWindow(std::string_view text) {
+  if (text.empty()) throw std::invalid_argument("missing window");
+  long long scale = 1;
+  switch (text.back()) {
+    case 's':
+      break;
+    case 'm':
+      scale = 60;
+      break;
+    case 'h':
+      scale = 3600;
+      break;
+    case 'd':
+      scale = 86400;
+      break;
+    default:
+      throw std::invalid_argument("window needs a unit (s, m, h or d)");
+  }
+  const long long amount =
+      std::stoll(std::string(text.substr(0, text.size() - 1)));
+  if (amount <= 0) throw std::invalid_argument("window must be positive");
+  return std::chrono::seconds(amount * scale);
+}
+
+// Fires every threshold t with from < t <= to, i.e. crossed going upwards.
+template <class Entry, class Value, class Key>
+void fireUpward(const std::vector<Entry>& sorted, Value from, Value to,
+                Key key, std::size_t index, double value,
+                std::vector<AlertEvent>& out) {
+  if (!(from < to)) return;
+  auto less = [&](Value v, const Entry& e) { return v < key(e); };
+  auto first = std::upper_bound(sorted.begin(), sorted.end(), from, less);
+  auto last = std::upper_bound(first, sorted.end(), to, less);
+  for (; first != last; ++first) out.push_back({first->rule, index, value});
+}
+
+// Fires every threshold t with to <= t < from, i.e. crossed going downwards.
+template <class Entry, class Value, class Key>
+void fireDownward(const std::vector<Entry>& sorted, Value from, Value to,
+                  Key key, std::size_t index, double value,
+                  std::vector<AlertEvent>& out) {
+  if (!(to < from)) return;
+  auto less = [&](const Entry& e, Value v) { return key(e) < v; };
+  auto first = std::lower_bound(sorted.begin(), sorted.end(), to, less);
+  auto last = std::lower_bound(first, sorted.end(), from, less);
+  for (; first != last; ++first) out.push_back({first->rule, index, value});
+}
+}  // namespace
+
+AlertRule AlertRule::parse(std::string_view spec) {
+  const auto op = spec.find_first_of("<>%~");
+  if (op == std::string_view::npos || op == 0) {
+    throw std::invalid_argument("Invalid alert rule '" + std::string(spec) +
+                                "' (expected e.g. USD>120000)");
+  }
+  AlertRule rule;
+  rule.symbol = std::string(spec.substr(0, op));
+  const std::string_view value = spec.substr(op + 1);
+  try {
+    switch (spec[op]) {
+      case '>':
+      case '<':
+      case '~':
+        rule.kind = spec[op] == '>'   ? Kind::CrossAbove
+                    : spec[op] == '<' ? Kind::CrossBelow
+                                      : Kind::SpreadAbove;
+        if (!Price::parse(value, rule.threshold)) {
+          throw std::invalid_argument("bad threshold");
+        }
+        break;
+      case '%': {
+        rule.kind = Kind::PercentMove;
+        const auto slash = value.find('/');
+        if (slash == std::string_view::npos) {
+          throw std::invalid_argument("percent rules need a /window");
+        }
+        rule.percent = std::stod(std::string(value.substr(0, slash)));
+        rule.window = parseWindow(value.substr(slash + 1));
+        if (!(rule.percent > 0)) {
+          throw std::invalid_argument("percent must be positive");
+        }
+        break;
+      }
+    }
+  } catch (const std::exception& e) {
+    throw std::invalid_argument("Invalid alert rule '" + std::string(spec) +
+                                "': " + e.what());
+  }
+  return rule;
+}
+
+std::string AlertRule::describe() const {
+  fmt::memory_buffer text;
+  this->describeTo(fmt::appender(text));
+  return fmt::to_string(text);
+}
+
+fmt::appender AlertRule::describeTo(fmt::appender out) const {
+  switch (this->kind) {
+    case Kind::CrossAbove:
+      return fmt::format_to(out, "{} crossed above {}", this->symbol,
+                            this->threshold);
+    case Kind::CrossBelow:
+      return fmt::format_to(out, "{} crossed below {}", this->symbol,
+                            this->threshold);
+    case Kind::PercentMove:
+      return fmt::format_to(out, "{} moved {:.2f}% within {}s", this->symbol,
+                            this->percent, this->window.count());
+    case Kind::SpreadAbove:
+    default:
+      return fmt::format_to(out, "{} spread widened to {}", this->symbol,
+                            this->threshold);
+  }
+}
+
+std::uint32_t AlertEngine::add(AlertRule rule) {
+  this->rules.push_back(std::move(rule));
+  this->dirty = true;
+  return static_cast<std::uint32_t>(this->rules.size() - 1);
+}
+
+void AlertEngine::loadFile(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("Cannot open alert file: " + path);
+  std::string line;
+  while (std::getline(in, line)) {
+    const auto first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#') continue;
+    const auto last = line.find_last_not_of(" \t\r");
+    this->add(AlertRule::parse(
+        std::string_view(line).substr(first, last - first + 1)));
+  }
+}
+
+void AlertEngine::compile() {
+  // Keep history/primed state, rebuild only the threshold indexes.
+  for (auto& [symbol, entry] : this->bySymbol) {
+    entry.above.clear();
+    entry.below.clear();
+    entry.spread.clear();
+    entry.percent.clear();
+    entry.maxWindow = std::chrono::seconds(0);
+  }
+  for (std::uint32_t id = 0; id < this->rules.size(); ++id) {
+    const AlertRule& rule = this->rules[id];
+    SymbolRules& entry = this->bySymbol[rule.symbol];
+    switch (rule.kind) {
+      case AlertRule::Kind::CrossAbove:
+        entry.above.push_back({rule.threshold, id});
+        break;
+      case AlertRule::Kind::CrossBelow:
+        entry.below.push_back({rule.threshold, id});
+        break;
+      case AlertRule::Kind::SpreadAbove:
+        entry.spread.push_back({rule.threshold, id});
+        break;
+      case AlertRule::Kind::PercentMove: {
+        auto track = std::find_if(
+            entry.percent.begin(), entry.percent.end(),
+            [&](const PercentTrack& t) { return t.window == rule.window; });
+        if (track == entry.percent.end()) {
+          entry.percent.push_back({rule.window, {}, 0});
+          track = std::prev(entry.percent.end());
+        }
+        track->thresholds.push_back({rule.percent, id});
+        entry.maxWindow = std::max(entry.maxWindow, rule.window);
+        break;
+      }
+    }
+  }
+  auto byValue = [](const Threshold& a, const Threshold& b) {
+    return a.value < b.value;
+  };
+  for (auto& [symbol, entry] : this->bySymbol) {
+    std::sort(entry.above.begin(), entry.above.end(), byValue);
+    std::sort(entry.below.begin(), entry.below.end(), byValue);
+    std::sort(entry.spread.begin(), entry.spread.end(), byValue);
+    for (PercentTrack& track : entry.percent) {
+      std::sort(track.thresholds.begin(), track.thresholds.end(),
+                [](const PercentThreshold& a, const PercentThreshold& b) {
+                  return a.percent < b.percent;
+                });
+    }
+  }
+  this->dirty = false;
+}
+
+void AlertEngine::evaluate(const Snapshot& snapshot,
+                           std::vector<AlertEvent>& out) {
+  if (this->dirty) this->compile();
+  if (this->bySymbol.empty()) return;
+  for (std::size_t i = 0; i < snapshot.size(); ++i) {
+    auto it = this->bySymbol.find(std::string_view(snapshot.symbols[i]));
+    if (it == this->bySymbol.end()) continue;
+    Price spread = snapshot.sell[i] - snapshot.buy[i];
+    if (spread < Price()) spread = -spread;
+    this->evaluateSymbol(it->second, i, snapshot.last[i], spread,
+                         snapshot.fetchedAt, out);
+  }
+}
+
+void AlertEngine::evaluateSymbol(SymbolRules& entry, std::size_t index,
+                                 Price last, Price spread,
+                                 std::chrono::system_clock::time_point at,
+                                 std::vector<AlertEvent>& out) {
+  auto byPrice = [](const Threshold& t) { return t.value; };
+  if (entry.primed) {
+    fireUpward(entry.above, entry.lastPrice, last, byPrice, index,
+               last.toDouble(), out);
+    fireDownward(entry.below, entry.lastPrice, last, byPrice, index,
+                 last.toDouble(), out);
+    fireUpward(entry.spread, entry.lastSpread, spread, byPrice, index,
+               spread.toDouble(), out);
+  }
+
+  if (!entry.percent.empty()) {
+    entry.history.push_back({at, last});
+    while (entry.history.front().at < at - entry.maxWindow) {
+      entry.history.pop_front();
+    }
+    for (PercentTrack& track : entry.percent) {
+      // Reference is the oldest sample still inside this window.
+      auto ref = std::lower_bound(
+          entry.history.begin(), entry.history.end(), at - track.window,
+          [](const Sample& s, std::chrono::system_clock::time_point t) {
+            return s.at < t;
+          });
+      double move = 0;
+      if (ref->last.cents() != 0) {
+        move = std::fabs(static_cast<double>(last.cents() - ref->last.cents()) /
+                         static_cast<double>(ref->last.cents())) *
+               100.0;
+      }
+      if (entry.primed) {
+        fireUpward(track.thresholds, track.lastMove, move,
+                   [](const PercentThreshold& t) { return t.percent; }, index,
+                   move, out);
+      }
+      track.lastMove = move;
+    }
+  }
+
+  entry.lastPrice = last;
+  entry.lastSpread = spread;
+  entry.primed = true;
+}
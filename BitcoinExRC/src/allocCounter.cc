@@ -0,0 +1,70 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/allocCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<std::uint64_t> allocations{0};
+std::atomic<std::uint64_t> allocatedBytes{0};
+
+void* countedAllocate(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc();
+}
+
+// std::pmr::new_delete_resource() goes through the aligned overloads.
+void* countedAllocate(std::size_t size, std::align_val_t alignment) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  const auto align = static_cast<std::size_t>(alignment);
+  size = (size + align - 1) / align * align;
+#ifdef _WIN32
+  void* p = _aligned_malloc(size == 0 ? align : size, align);
+#else
+  void* p = std::aligned_alloc(align, size == 0 ? align : size);
+#endif
+  if (p) return p;
+  throw std::bad_alloc();
+}
+
+void alignedFree(void* p) {
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+}  // namespace
+
+std::uint64_t globalAllocationCount() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+std::uint64_t globalAllocatedBytes() {
+  return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return countedAllocate(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return countedAllocate(size, alignment);
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  alignedFree(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+  alignedFree(p);
+}
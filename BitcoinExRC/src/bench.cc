@@ -0,0 +1,1397 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/bench.h"
+
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <utility>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "../include/alerts.h"
+#include "../include/allocCounter.h"
+#include "../include/bitcoin.h"
+#include "../include/candles.h"
+#include "../include/crossRates.h"
+#include "../include/curlHandler.h"
+#include "../include/deltaEncoder.h"
+#include "../include/liveTable.h"
+#include "../include/outputSink.h"
+#include "../include/price.h"
+#include "../include/rcuCell.h"
+#include "../include/render.h"
+#include "../include/sharedTicker.h"
+#include "../include/snapshotCache.h"
+#include "../include/snapshot.h"
+#include "../include/spscQueue.h"
+#include "../include/taskPool.h"
+#include "../include/tickArena.h"
+#include "../include/tickerDecoder.h"
+#include "../include/tickerGenerator.h"
+#include "../include/trace.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Average nanoseconds per call of `fn` over at least `minRuns` calls.
+template <class Fn>
+double nsPerRun(Fn&& fn, int minRuns = 50) {
+  fn();  // warm-up
+  auto start = Clock::now();
+  int runs = 0;
+  do {
+    fn();
+    ++runs;
+  } while (runs < minRuns ||
+           Clock::now() - start < std::chrono::milliseconds(200));
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+             .count() /
+         runs;
+}
+
+// Appends the non-empty lines of the --replay file at `path`. False, after
+// saying why, if it cannot be opened.
+bool readReplay(const std::string& path, std::vector<std::string>& payloads) {
+  std::ifstream in(path);
+  if (!in) {
+    fmt::print(fg(fmt::color::red), "Cannot open replay file: {}\n", path);
+    return false;
+  }
+  for (std::string line; std::getline(in, line);) {
+    if (!line.empty()) payloads.push_back(std::move(line));
+  }
+  return true;
+}
+
+// Fails unless decoding a small selection is clearly cheaper than
+// decoding every symbol: at most half the time for up to 5% of them.
+int benchParse() {
+  const std::size_t payloadSymbols = 1000;
+  const std::string payload = syntheticTicker(payloadSymbols);
+  fmt::print("Parse cost, {} symbols / {} bytes payload\n", payloadSymbols,
+             payload.size());
+  fmt::print("{:<22}{:>14}{:>14}{:>12}\n", "decoder", "us/parse", "MB/s",
+             "vs all");
+
+  auto report = [&](const std::string& label, double ns, double ofAll) {
+    fmt::print("{:<22}{:>14.2f}{:>14.1f}", label, ns / 1000.0,
+               static_cast<double>(payload.size()) / ns * 1000.0);
+    if (ofAll > 0) {
+      fmt::print("{:>11.2f}x", ofAll);
+    }
+    fmt::print("\n");
+  };
+
+  volatile std::size_t sink = 0;
+  report("nlohmann DOM (all)", nsPerRun([&] {
+           sink = sink + Snapshot::fromJson(nlohmann::json::parse(payload)).size();
+         }), 0);
+  // Each selection against a full decode timed right before it, best
+  // ratio of three rounds, so a noisy neighbour does not decide the
+  // verdict.
+  auto timeDecode = [&](std::size_t selected) {
+    std::vector<std::string> symbols;
+    if (selected != payloadSymbols) {
+      // Spread the selection over the payload so skipping is exercised.
+      for (std::size_t k = 0; k < selected; ++k) {
+        symbols.push_back(syntheticSymbol(k * payloadSymbols / selected));
+      }
+    }
+    const TickerDecoder decoder{SymbolFilter(symbols)};
+    Snapshot snapshot;
+    return nsPerRun([&] {
+      decoder.decode(payload, snapshot);
+      sink = sink + snapshot.size();
+    });
+  };
+  double all = 0;
+  int slow = 0;
+  for (std::size_t selected : {std::size_t{1}, std::size_t{2}, std::size_t{5},
+                               std::size_t{50}}) {
+    double ns = 0;
+    double ratio = 0;
+    for (int round = 0; round < 3; ++round) {
+      const double full = timeDecode(payloadSymbols);
+      const double part = timeDecode(selected);
+      if (all == 0 || full < all) all = full;
+      if (round == 0 || part / full < ratio) {
+        ns = part;
+        ratio = part / full;
+      }
+    }
+    report(fmt::format("projection {}", selected), ns, ratio);
+    if (ratio > 0.5) ++slow;
+  }
+  report(fmt::format("projection {} (all)", payloadSymbols), all, 1.0);
+  if (slow != 0) {
+    fmt::print(fg(fmt::color::red),
+               "{} projection(s) not clearly cheaper than a full decode\n",
+               slow);
+  }
+  return slow == 0 ? 0 : 1;
+}
+
+int benchFormat() {
+  // Spread over the magnitudes seen in the ticker, from cents to ARS.
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<std::int64_t> cents(1, 20'000'000'000);
+  std::vector<Price> prices(4096);
+  std::vector<double> doubles(prices.size());
+  for (std::size_t i = 0; i < prices.size(); ++i) {
+    prices[i] = Price::fromCents(cents(rng));
+    doubles[i] = prices[i].toDouble();
+  }
+
+  fmt::print("Formatting {} prices per run\n", prices.size());
+  fmt::print("{:<28}{:>14}\n", "formatter", "ns/value");
+  auto report = [&](const char* label, double ns) {
+    fmt::print("{:<28}{:>14.2f}\n", label,
+               ns / static_cast<double>(prices.size()));
+  };
+
+  fmt::memory_buffer out;
+  report("fmt double {:>12.2f}", nsPerRun([&] {
+           out.clear();
+           for (double value : doubles) {
+             fmt::format_to(std::back_inserter(out), "{:>12.2f}", value);
+           }
+         }));
+  report("fmt Price {:>12}", nsPerRun([&] {
+           out.clear();
+           for (Price price : prices) {
+             fmt::format_to(std::back_inserter(out), "{:>12}", price);
+           }
+         }));
+  char buffer[Price::MAX_CHARS];
+  volatile char sink = 0;
+  report("Price::formatTo", nsPerRun([&] {
+           for (Price price : prices) sink = *price.formatTo(buffer);
+         }));
+  return 0;
+}
+
+// Random JSON number text: mostly ticker-like decimals plus the odd shapes
+// (no/long fraction, exponent, negative) so rounding paths are covered.
+std::string randomNumberText(std::mt19937_64& rng) {
+  std::uniform_int_distribution<int> shape(0, 9);
+  std::uniform_int_distribution<std::int64_t> units(0, 999'999'999);
+  std::uniform_int_distribution<int> digit(0, 9);
+  std::string text = (shape(rng) == 0 ? "-" : "") + std::to_string(units(rng));
+  switch (shape(rng)) {
+    case 0:
+      break;
+    case 1:
+      text += fmt::format("e{}", shape(rng) - 4);
+      break;
+    default: {
+      text += '.';
+      const int decimals = 1 + shape(rng) % 5;
+      for (int k = 0; k < decimals; ++k) {
+        text += static_cast<char>('0' + digit(rng));
+      }
+    }
+  }
+  return text;
+}
+
+// Differential check of Price::fromChars against the nlohmann number lexer,
+// then throughput of both.
+int benchNumbers() {
+  std::mt19937_64 rng(7);
+  const std::size_t fuzzCases = 200'000;
+  std::size_t mismatches = 0;
+  for (std::size_t i = 0; i < fuzzCases; ++i) {
+    const std::string text = randomNumberText(rng);
+    Price fast;
+    if (!Price::parse(text, fast)) {
+      fmt::print(fg(fmt::color::red), "rejected valid number '{}'\n", text);
+      ++mismatches;
+      continue;
+    }
+    const Price reference =
+        Price::fromDouble(nlohmann::json::parse(text).get<double>());
+    // Up to two decimals both must be exact; beyond that the double path
+    // may land on the other side of a half cent.
+    const auto dot = text.find('.');
+    const bool exact = text.find('e') == std::string::npos &&
+                       (dot == std::string::npos || text.size() - dot <= 3);
+    const std::int64_t diff = fast.cents() - reference.cents();
+    if (exact ? diff != 0 : (diff > 1 || diff < -1)) {
+      if (++mismatches <= 10) {
+        fmt::print(fg(fmt::color::red), "mismatch '{}': {} vs {}\n", text,
+                   fast, reference);
+      }
+    }
+  }
+  fmt::print("Differential: {} cases, {} mismatches\n", fuzzCases,
+             mismatches);
+
+  std::vector<std::string> texts(4096);
+  for (std::string& text : texts) {
+    text = fmt::format("{}.{:02}", rng() % 200'000'000, rng() % 100);
+  }
+  fmt::print("{:<28}{:>16}\n", "parser", "Mnumbers/s");
+  auto report = [&](const char* label, double ns) {
+    fmt::print("{:<28}{:>16.2f}\n", label,
+               static_cast<double>(texts.size()) / ns * 1000.0);
+  };
+  volatile std::int64_t sink = 0;
+  report("nlohmann number lexer", nsPerRun([&] {
+           for (const std::string& text : texts) {
+             sink = sink + nlohmann::json::parse(text).get<std::int64_t>();
+           }
+         }));
+  report("std::strtod", nsPerRun([&] {
+           for (const std::string& text : texts) {
+             sink = sink + static_cast<std::int64_t>(
+                               std::strtod(text.c_str(), nullptr));
+           }
+         }));
+  report("Price::fromChars", nsPerRun([&] {
+           Price price;
+           for (const std::string& text : texts) {
+             Price::fromChars(text.data(), text.data() + text.size(), price);
+             sink = sink + price.cents();
+           }
+         }));
+  return mismatches == 0 ? 0 : 1;
+}
+
+// Replays a ticker through validate -> decode -> render (plus cross rates
+// and alerts on the arena side) and counts global heap allocations per
+// steady-state tick, with and without the arena. The last row drives the
+// real-time loop's own tick body, LiveTable, with the pool consumers, the
+// cross table, alerts and the snapshot cache, over --replay lines if given;
+// the network fetch is the only part of a tick it leaves out.
+int benchAlloc(const BenchOptions& options) {
+  // Alternating payloads, so cross rates and alerts see prices move.
+  std::vector<std::string> payloads;
+  if (!options.replay.empty()) {
+    if (!readReplay(options.replay, payloads)) return 1;
+  }
+  if (payloads.empty()) {
+    payloads = {syntheticTicker(32, 0), syntheticTicker(32, 1)};
+  }
+  const std::string& payload = payloads[0];
+  const TickerDecoder decoder;
+  const int warmup = 10;
+  const int ticks = 1000;
+  volatile std::size_t sink = 0;
+
+  CrossRateEngine crossRates;
+  AlertEngine alerts;
+  alerts.add(AlertRule::parse(syntheticSymbol(1) + ">1"));
+  std::vector<AlertEvent> events;
+  events.reserve(64);
+  TickArena arena;
+  auto arenaTick = [&](int tick) {
+    arena.reset();
+    Snapshot snapshot(arena.allocator());
+    decoder.decode(
+        BitCoin::validateAndCleanJson(payloads[tick % payloads.size()]),
+        snapshot);
+    FrameBuffer frame(arena.allocator());
+    renderTable(frame, snapshot, tick, std::chrono::seconds(5));
+    crossRates.update(snapshot);
+    events.clear();
+    alerts.evaluate(snapshot, events);
+    sink = sink + frame.size() + events.size();
+  };
+  auto heapTick = [&](int tick) {
+    Snapshot snapshot;
+    decoder.decode(BitCoin::validateAndCleanJson(payload), snapshot);
+    FrameBuffer frame;
+    renderTable(frame, snapshot, tick, std::chrono::seconds(5));
+    sink = sink + frame.size();
+  };
+
+  auto perTick = [&](auto&& tickFn) {
+    for (int i = 0; i < warmup; ++i) tickFn(i);
+    const std::uint64_t before = globalAllocationCount();
+    for (int i = 0; i < ticks; ++i) tickFn(i);
+    return static_cast<double>(globalAllocationCount() - before) / ticks;
+  };
+#ifdef _WIN32
+  const char* devNull = "NUL";
+#else
+  const char* devNull = "/dev/null";
+#endif
+  std::FILE* screen = std::fopen(devNull, "w");
+  if (screen == nullptr) {
+    fmt::print(fg(fmt::color::red), "Cannot open {}\n", devNull);
+    return 1;
+  }
+  const std::filesystem::path cachePath =
+      std::filesystem::temp_directory_path() /
+      fmt::format("bitcoinexrc-bench-{}.bin", std::random_device{}());
+  const SnapshotCache cache(cachePath.string());
+  TaskPool pool(2);
+  LiveTable::Options tableOptions;
+  tableOptions.interval = std::chrono::seconds(5);
+  tableOptions.showCross = true;
+  tableOptions.cache = &cache;
+  tableOptions.out = screen;
+  LiveTable table(pool, alerts, std::move(tableOptions));
+  auto liveTick = [&](int tick) {
+    TickArena& tickArena = table.beginTick();
+    Snapshot snapshot(tickArena.allocator());
+    decoder.decode(
+        BitCoin::validateAndCleanJson(payloads[tick % payloads.size()]),
+        snapshot);
+    table.show(snapshot, tick);
+  };
+
+  const double heap = perTick(heapTick);
+  const double arenaAllocs = perTick(arenaTick);
+  const double liveAllocs = perTick(liveTick);
+  fmt::print("Global allocations per tick over {} ticks ({})\n", ticks,
+             options.replay.empty() ? "synthetic" : "replay");
+  fmt::print("{:<28}{:>10.2f}\n", "default heap", heap);
+  fmt::print("{:<28}{:>10.2f}\n", "per-tick arena", arenaAllocs);
+  fmt::print("{:<28}{:>10.2f}\n", "live table tick", liveAllocs);
+  fmt::print("{:<28}{:>10.2f}\n", "arena us/tick",
+             nsPerRun([&] { arenaTick(0); }) / 1000.0);
+  fmt::print("{:<28}{:>10.2f}\n", "live table us/tick",
+             nsPerRun([&] { liveTick(0); }) / 1000.0);
+  std::fclose(screen);
+  std::error_code ignored;
+  std::filesystem::remove(cachePath, ignored);
+  return arenaAllocs == 0.0 && liveAllocs == 0.0 ? 0 : 1;
+}
+
+// 100k rules over 32 symbols, evaluated on a random walk: the interval
+// index against a naive scan of every rule per tick.
+int benchAlerts() {
+  const std::size_t symbolCount = 32;
+  const std::size_t ruleCount = 100'000;
+  const int ticks = 2000;
+  std::mt19937_64 rng(11);
+
+  Snapshot snapshot;
+  for (std::size_t i = 0; i < symbolCount; ++i) {
+    const Price price = Price::fromCents(10'000'000 + 100'000 * i);
+    snapshot.push(syntheticSymbol(i), price, price,
+                  price - Price::fromCents(50), price + Price::fromCents(50));
+  }
+
+  AlertEngine engine;
+  std::vector<AlertRule> rules;
+  std::uniform_int_distribution<int> kind(0, 9);
+  std::uniform_int_distribution<std::int64_t> offset(-200'000, 200'000);
+  for (std::size_t r = 0; r < ruleCount; ++r) {
+    const std::size_t i = rng() % symbolCount;
+    AlertRule rule;
+    rule.symbol = syntheticSymbol(i);
+    const int k = kind(rng);
+    if (k < 4) {
+      rule.kind = AlertRule::Kind::CrossAbove;
+      rule.threshold = snapshot.last[i] + Price::fromCents(offset(rng));
+    } else if (k < 8) {
+      rule.kind = AlertRule::Kind::CrossBelow;
+      rule.threshold = snapshot.last[i] + Price::fromCents(offset(rng));
+    } else if (k < 9) {
+      rule.kind = AlertRule::Kind::SpreadAbove;
+      rule.threshold =
+          Price::fromCents(100 + static_cast<std::int64_t>(rng() % 400));
+    } else {
+      rule.kind = AlertRule::Kind::PercentMove;
+      rule.percent = 0.1 + static_cast<double>(rng() % 100) / 50.0;
+      rule.window = std::chrono::seconds(60 * (1 + rng() % 15));
+    }
+    rules.push_back(rule);
+    engine.add(rule);
+  }
+
+  // Pre-generate the walk so both contenders see the same ticks.
+  std::vector<Snapshot> walk;
+  std::normal_distribution<double> step(0.0, 2000.0);
+  auto now = std::chrono::system_clock::now();
+  for (int t = 0; t < ticks; ++t) {
+    for (std::size_t i = 0; i < symbolCount; ++i) {
+      const auto delta = static_cast<std::int64_t>(step(rng));
+      snapshot.last[i] += Price::fromCents(delta);
+      snapshot.buy[i] = snapshot.last[i] - Price::fromCents(50 + delta % 200);
+      snapshot.sell[i] = snapshot.last[i] + Price::fromCents(50);
+    }
+    snapshot.fetchedAt = now + std::chrono::seconds(5 * t);
+    walk.push_back(snapshot);
+  }
+
+  std::vector<AlertEvent> events;
+  std::size_t fired = 0;
+  std::size_t priceFired = 0;
+  auto start = Clock::now();
+  for (const Snapshot& tick : walk) {
+    events.clear();
+    engine.evaluate(tick, events);
+    fired += events.size();
+  }
+  const double indexedNs =
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count() /
+      ticks;
+  // Second pass on a fresh engine only to cross-check the price-rule hits.
+  AlertEngine check;
+  for (const AlertRule& rule : rules) check.add(rule);
+  for (const Snapshot& tick : walk) {
+    events.clear();
+    check.evaluate(tick, events);
+    for (const AlertEvent& event : events) {
+      const auto kind = check.rule(event.rule).kind;
+      priceFired += kind == AlertRule::Kind::CrossAbove ||
+                    kind == AlertRule::Kind::CrossBelow;
+    }
+  }
+
+  // Naive: every rule checked every tick (price and spread rules only).
+  std::vector<Price> previous(walk.front().last.begin(),
+                              walk.front().last.end());
+  std::vector<std::size_t> ruleSymbol;
+  for (const AlertRule& rule : rules) {
+    ruleSymbol.push_back(*walk.front().indexOf(rule.symbol));
+  }
+  std::size_t naiveFired = 0;
+  start = Clock::now();
+  for (const Snapshot& tick : walk) {
+    for (std::size_t r = 0; r < rules.size(); ++r) {
+      const AlertRule& rule = rules[r];
+      const std::size_t i = ruleSymbol[r];
+      const Price before = previous[i];
+      const Price now = tick.last[i];
+      if (rule.kind == AlertRule::Kind::CrossAbove) {
+        naiveFired += before < rule.threshold && rule.threshold <= now;
+      } else if (rule.kind == AlertRule::Kind::CrossBelow) {
+        naiveFired += now <= rule.threshold && rule.threshold < before;
+      }
+    }
+    std::copy(tick.last.begin(), tick.last.end(), previous.begin());
+  }
+  const double naiveNs =
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count() /
+      ticks;
+
+  fmt::print("{} rules over {} symbols, {} ticks\n", ruleCount, symbolCount,
+             ticks);
+  fmt::print("{:<28}{:>14}{:>14}{:>14}\n", "evaluator", "us/tick",
+             "fired/tick", "price/tick");
+  fmt::print("{:<28}{:>14.2f}{:>14.1f}{:>14.1f}\n", "interval index (all)",
+             indexedNs / 1000, static_cast<double>(fired) / ticks,
+             static_cast<double>(priceFired) / ticks);
+  fmt::print("{:<28}{:>14.2f}{:>14}{:>14.1f}\n", "naive scan (price only)",
+             naiveNs / 1000, "-", static_cast<double>(naiveFired) / ticks);
+  return priceFired == naiveFired ? 0 : 1;
+}
+
+// Records/s of each --format sink into the null device, for a 1000-symbol
+// snapshot alone and including decode (what --replay does per tick).
+int benchSinks() {
+#ifdef _WIN32
+  const std::string devNull = "NUL";
+#else
+  const std::string devNull = "/dev/null";
+#endif
+  const std::string payload = syntheticTicker(1000);
+  const TickerDecoder decoder;
+  const Snapshot snapshot = decoder.decode(payload);
+
+  fmt::print("{:<10}{:>20}{:>24}\n", "format", "Mrec/s (sink only)",
+             "Mrec/s (decode+sink)");
+  for (auto [name, format] : {std::pair{"ndjson", OutputFormat::Ndjson},
+                              std::pair{"csv", OutputFormat::Csv},
+                              std::pair{"bin", OutputFormat::Binary}}) {
+    auto sink = OutputSink::create(format, devNull, 0);
+    const double sinkNs = nsPerRun([&] { sink->write(snapshot); });
+    TickArena arena;
+    const double replayNs = nsPerRun([&] {
+      arena.reset();
+      Snapshot decoded(arena.allocator());
+      decoder.decode(payload, decoded);
+      sink->write(decoded);
+    });
+    const auto mrecs = [&](double ns) {
+      return static_cast<double>(snapshot.size()) / ns * 1000.0;
+    };
+    fmt::print("{:<10}{:>20.2f}{:>24.2f}\n", name, mrecs(sinkNs),
+               mrecs(replayNs));
+  }
+  return 0;
+}
+
+// Bytes per tick of each --format with and without --delta, and the cost
+// of the change scan, over a 10k-symbol ticker where 0.1% to 100% of the
+// symbols move between ticks. The naive scan compares every field of
+// every symbol; the encoder skips unchanged blocks of eight.
+int benchDelta() {
+#ifdef _WIN32
+  const std::string devNull = "NUL";
+#else
+  const std::string devNull = "/dev/null";
+#endif
+  const std::size_t symbols = 10'000;
+  const std::size_t ticks = 120;
+  const TickerDecoder decoder;
+  const Snapshot base = decoder.decode(syntheticTicker(symbols));
+  std::mt19937 rng(42);
+  std::vector<std::size_t> order(symbols);
+  for (std::size_t i = 0; i < symbols; ++i) order[i] = i;
+  std::shuffle(order.begin(), order.end(), rng);
+
+  fmt::print("{} symbols, keyframe every {} ticks\n", symbols,
+             DeltaEncoder::DEFAULT_KEYFRAME_EVERY);
+  fmt::print("{:>8}  {:<8}{:>14}{:>14}{:>9}{:>14}{:>14}\n", "changed",
+             "format", "KB/tick full", "KB/tick delta", "ratio",
+             "ns/sym naive", "ns/sym delta");
+  int failures = 0;
+  for (double rate : {0.001, 0.01, 0.1, 1.0}) {
+    // Ticks alternate between `base` and `moved`, which differs from it in
+    // the `last` price of the first `changed` shuffled symbols.
+    const auto changed = static_cast<std::size_t>(rate * symbols);
+    Snapshot moved = base;
+    for (std::size_t k = 0; k < changed; ++k) {
+      moved.last[order[k]] += Price::fromCents(1);
+    }
+    const Snapshot* frames[] = {&base, &moved};
+
+    std::size_t naiveFound = 0;
+    const double naiveNs = nsPerRun([&] {
+      naiveFound = 0;
+      for (std::size_t i = 0; i < symbols; ++i) {
+        naiveFound += base.m15[i] != moved.m15[i] ||
+                      base.last[i] != moved.last[i] ||
+                      base.buy[i] != moved.buy[i] ||
+                      base.sell[i] != moved.sell[i];
+      }
+    });
+    DeltaEncoder encoder(0);
+    encoder.encode(base);
+    std::size_t flip = 1;
+    std::size_t deltaFound = 0;
+    const double deltaNs = nsPerRun([&] {
+      deltaFound = encoder.encode(*frames[flip]).size();
+      flip ^= 1;
+    });
+    if (naiveFound != changed || deltaFound != changed) {
+      fmt::print(fg(fmt::color::red), "  found {} / {} of {} changes\n",
+                 naiveFound, deltaFound, changed);
+      ++failures;
+    }
+
+    for (auto [name, format] : {std::pair{"ndjson", OutputFormat::Ndjson},
+                                std::pair{"csv", OutputFormat::Csv},
+                                std::pair{"bin", OutputFormat::Binary}}) {
+      auto perTick = [&](std::size_t keyframeEvery) {
+        auto sink = OutputSink::create(format, devNull, 0, keyframeEvery);
+        for (std::size_t t = 0; t < ticks; ++t) sink->write(*frames[t % 2]);
+        return static_cast<double>(sink->bytes()) / ticks / 1024.0;
+      };
+      const double full = perTick(0);
+      const double delta = perTick(DeltaEncoder::DEFAULT_KEYFRAME_EVERY);
+      fmt::print(
+          "{:>7.1f}%  {:<8}{:>14.1f}{:>14.1f}{:>8.1f}x{:>14.2f}{:>14.2f}\n",
+          rate * 100.0, name, full, delta, full / delta,
+          naiveNs / static_cast<double>(symbols),
+          deltaNs / static_cast<double>(symbols));
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
+
+// A simulated 6 hours at one tick per second through CandleAggregator,
+// against a per-tick hash lookup of every symbol with a boundary check on
+// each of its candles. The first symbol's closed candles are checked
+// against the naive ones at every resolution.
+int benchCandles() {
+  const std::size_t sizes[] = {10, 1'000, 10'000};
+  const std::uint32_t seconds = 6 * 3600;
+  const std::size_t variants = 16;
+  const auto start = std::chrono::system_clock::time_point(
+      std::chrono::hours(24 * 20'000));  // a midnight, UTC
+  const TickerDecoder decoder;
+
+  struct Naive {
+    Candle open[CANDLE_RESOLUTION_COUNT];
+  };
+  fmt::print("{} ticks, {} resolutions\n", seconds, CANDLE_RESOLUTION_COUNT);
+  fmt::print("{:>8}{:>14}{:>14}{:>12}{:>12}\n", "symbols", "ns/sym naive",
+             "ns/sym ring", "closed", "state MB");
+  int failures = 0;
+  for (std::size_t symbols : sizes) {
+    // Variants of one payload that differ in the last prices only, so the
+    // symbol set (and its hash) stays the same from tick to tick.
+    std::vector<Snapshot> frames(variants, decoder.decode(syntheticTicker(symbols)));
+    std::mt19937_64 rng(7);
+    for (Snapshot& frame : frames) {
+      for (Price& price : frame.last) {
+        price += Price::fromCents(static_cast<std::int64_t>(rng() % 2001) - 1000);
+      }
+    }
+    auto tickAt = [&](std::uint32_t t) -> Snapshot& {
+      Snapshot& frame = frames[(t * 7) % variants];
+      frame.fetchedAt = start + std::chrono::seconds(t);
+      return frame;
+    };
+
+    std::unordered_map<std::string, Naive> naive;
+    std::vector<Candle> naiveClosed[CANDLE_RESOLUTION_COUNT];
+    const std::string first(frames[0].symbols[0]);
+    const auto naiveBegin = Clock::now();
+    for (std::uint32_t t = 0; t < seconds; ++t) {
+      const Snapshot& frame = tickAt(t);
+      const std::int64_t now =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              frame.fetchedAt.time_since_epoch())
+              .count();
+      for (std::size_t i = 0; i < frame.size(); ++i) {
+        Naive& entry = naive[std::string(frame.symbols[i])];
+        const Price price = frame.last[i];
+        for (std::size_t r = 0; r < CANDLE_RESOLUTION_COUNT; ++r) {
+          const auto bucket = static_cast<std::uint32_t>(
+              now / std::chrono::duration_cast<std::chrono::milliseconds>(
+                        CANDLE_RESOLUTIONS[r].length)
+                        .count());
+          Candle& candle = entry.open[r];
+          if (candle.ticks != 0 && candle.bucket != bucket) {
+            if (i == 0) naiveClosed[r].push_back(candle);
+            candle.ticks = 0;
+          }
+          if (candle.ticks == 0) {
+            candle = {price, price, price, price, bucket, 1};
+            continue;
+          }
+          candle.high = std::max(candle.high, price);
+          candle.low = std::min(candle.low, price);
+          candle.close = price;
+          ++candle.ticks;
+        }
+      }
+    }
+    const double naiveNs =
+        std::chrono::duration<double, std::nano>(Clock::now() - naiveBegin)
+            .count();
+
+    CandleAggregator aggregator;
+    std::vector<ClosedCandle> closed;
+    std::size_t closedCount = 0;
+    const auto ringBegin = Clock::now();
+    for (std::uint32_t t = 0; t < seconds; ++t) {
+      closed.clear();
+      aggregator.update(tickAt(t), closed);
+      closedCount += closed.size();
+    }
+    const double ringNs =
+        std::chrono::duration<double, std::nano>(Clock::now() - ringBegin)
+            .count();
+
+    for (std::size_t r = 0; r < CANDLE_RESOLUTION_COUNT; ++r) {
+      const std::vector<Candle> kept = aggregator.recent(first, r);
+      const std::vector<Candle>& expected = naiveClosed[r];
+      bool same = kept.size() == std::min(expected.size(),
+                                          CandleAggregator::DEFAULT_KEEP);
+      for (std::size_t k = 0; same && k < kept.size(); ++k) {
+        const Candle& a = kept[k];
+        const Candle& b = expected[expected.size() - kept.size() + k];
+        same = a.bucket == b.bucket && a.open == b.open && a.high == b.high &&
+               a.low == b.low && a.close == b.close && a.ticks == b.ticks;
+      }
+      if (!same) {
+        fmt::print(fg(fmt::color::red), "  {} candles of {} differ\n",
+                   CANDLE_RESOLUTIONS[r].name, first);
+        ++failures;
+      }
+    }
+    const double updates = static_cast<double>(symbols) * seconds;
+    const double stateBytes = static_cast<double>(
+        symbols * CANDLE_RESOLUTION_COUNT *
+        ((CandleAggregator::DEFAULT_KEEP + 1) * sizeof(Candle) +
+         sizeof(std::uint32_t)));
+    fmt::print("{:>8}{:>14.2f}{:>14.2f}{:>12}{:>12.2f}\n", symbols,
+               naiveNs / updates, ringNs / updates, closedCount,
+               stateBytes / 1048576.0);
+  }
+  return failures == 0 ? 0 : 1;
+}
+
+// Two threads hammer one queue. Block must deliver every item in order;
+// drop-oldest may lose items but never reorder or duplicate them, and
+// pushed = popped + dropped once drained.
+int benchQueue() {
+  const std::uint64_t items = 2'000'000;
+  int failures = 0;
+  fmt::print("SPSC queue, {} items, capacity 64, producer -> consumer\n",
+             items);
+  for (OverflowPolicy policy :
+       {OverflowPolicy::Block, OverflowPolicy::DropOldest}) {
+    SpscQueue<std::uint64_t> queue(64, policy);
+    std::uint64_t received = 0;
+    bool ordered = true;
+    const auto start = Clock::now();
+    std::thread consumer([&] {
+      std::uint64_t value = 0;
+      std::uint64_t previous = 0;
+      while (queue.pop(value)) {
+        if (value <= previous) ordered = false;
+        if (policy == OverflowPolicy::Block && value != previous + 1) {
+          ordered = false;
+        }
+        previous = value;
+        ++received;
+      }
+    });
+    for (std::uint64_t i = 1; i <= items; ++i) queue.push(i);
+    queue.close();
+    consumer.join();
+    const double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    const auto stats = queue.stats();
+    const bool balanced =
+        stats.pushed == items && stats.popped == received &&
+        stats.popped + stats.dropped == stats.pushed;
+    const bool ok = ordered && balanced &&
+                    (policy == OverflowPolicy::DropOldest || received == items);
+    fmt::print("  {:<12} {:6.1f} M items/s, received {}, dropped {}, "
+               "depth mean {:.1f}, blocked {:.1f} ms  {}\n",
+               policy == OverflowPolicy::Block ? "block" : "drop-oldest",
+               static_cast<double>(items) / seconds / 1e6, received,
+               stats.dropped,
+               static_cast<double>(stats.depthSum) /
+                   static_cast<double>(stats.pushed),
+               std::chrono::duration<double, std::milli>(stats.blocked).count(),
+               ok ? "ok" : "FAILED");
+    if (!ok) ++failures;
+  }
+  return failures == 0 ? 0 : 1;
+}
+
+// Heap traffic of the response body over repeated fetches of --url (a
+// local server): the handle keeping its buffer, the body taken and freed
+// every tick (pipeline without recycling), and taken then recycled. Then a
+// --max-body below the body size, which must abort instead of buffering.
+int benchBody(const BenchOptions& options) {
+  if (options.url == BitCoin::DEFAULT_URL) {
+    fmt::print(fg(fmt::color::red),
+               "body needs --url pointing at a local server, e.g. "
+               "tools/standin_server.py --symbols 20000\n");
+    return 1;
+  }
+  const int fetches = 50;
+  enum class Mode { Keep, Take, Recycle };
+  std::size_t bodyBytes = 0;
+  fmt::print("{:<16}{:>14}{:>14}{:>12}{:>12}\n", "body buffer", "allocs/fetch",
+             "KB new/fetch", "growths", "ms/fetch");
+  for (auto [name, mode] : {std::pair{"kept", Mode::Keep},
+                            std::pair{"taken, freed", Mode::Take},
+                            std::pair{"taken, recycled", Mode::Recycle}}) {
+    CurlHandler handle;
+    handle.setUrl(options.url);
+    auto fetch = [&, mode = mode] {
+      handle.fetch();
+      bodyBytes = handle.getFetchedData().size();
+      if (mode == Mode::Keep) return;
+      std::string body = handle.takeFetchedData();
+      if (mode == Mode::Recycle) CurlHandler::recycle(std::move(body));
+    };
+    fetch();  // connect and first sizing happen outside the measurement
+    std::size_t growths = 0;
+    const std::uint64_t allocs = globalAllocationCount();
+    const std::uint64_t bytes = globalAllocatedBytes();
+    const auto start = Clock::now();
+    for (int i = 0; i < fetches; ++i) {
+      fetch();
+      growths += handle.lastBodyGrowths();
+    }
+    const double ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count();
+    fmt::print("{:<16}{:>14.1f}{:>14.1f}{:>12.2f}{:>12.2f}\n", name,
+               static_cast<double>(globalAllocationCount() - allocs) / fetches,
+               static_cast<double>(globalAllocatedBytes() - bytes) / 1024.0 /
+                   fetches,
+               static_cast<double>(growths) / fetches, ms / fetches);
+  }
+
+  CurlHandler limited;
+  limited.setUrl(options.url);
+  limited.setMaxBody(bodyBytes / 2);
+  const auto start = Clock::now();
+  try {
+    limited.fetch();
+  } catch (const std::exception& e) {
+    fmt::print("\n{} byte body, --max-body {}: aborted after {:.2f} ms\n"
+               "  {}\n",
+               bodyBytes, bodyBytes / 2,
+               std::chrono::duration<double, std::milli>(Clock::now() - start)
+                   .count(),
+               e.what());
+    return 0;
+  }
+  fmt::print(fg(fmt::color::red),
+             "--max-body {} did not abort a {} byte body\n", bodyBytes / 2,
+             bodyBytes);
+  return 1;
+}
+
+// N threads asking for the ticker at the same instant, 20 rounds: every
+// thread on its own client (one request each), through a SharedTicker
+// sharing the in-flight request, and with a 1s staleness window on top.
+int benchCoalesce(const BenchOptions& options) {
+  if (options.url == BitCoin::DEFAULT_URL) {
+    fmt::print(fg(fmt::color::red),
+               "coalesce needs --url pointing at a local server, e.g. "
+               "tools/standin_server.py\n");
+    return 1;
+  }
+  const std::size_t threads = options.workers == 0 ? 8 : options.workers;
+  const int rounds = 20;
+  const TickerDecoder decoder;
+  enum class Mode { Own, Shared, Window };
+  fmt::print("{} threads per round, {} rounds against {}\n", threads, rounds,
+             options.url);
+  fmt::print("{:<20}{:>16}{:>12}{:>12}\n", "callers", "requests/round",
+             "ms/round", "errors");
+  for (auto [name, mode] : {std::pair{"own client each", Mode::Own},
+                            std::pair{"shared, in-flight", Mode::Shared},
+                            std::pair{"shared, 1s window", Mode::Window}}) {
+    std::vector<std::unique_ptr<BitCoin>> clients;
+    for (std::size_t t = 0; t < (mode == Mode::Own ? threads : 1); ++t) {
+      clients.push_back(std::make_unique<BitCoin>(options.url));
+      clients.back()->fetchSnapshot(decoder);  // connect outside the timing
+    }
+    SharedTicker shared(*clients.front(), decoder,
+                        mode == Mode::Window ? std::chrono::seconds(1)
+                                             : std::chrono::seconds(0));
+    std::atomic<std::uint64_t> errors{0};
+    std::barrier start(static_cast<std::ptrdiff_t>(threads) + 1);
+    std::vector<std::thread> callers;
+    for (std::size_t t = 0; t < threads; ++t) {
+      callers.emplace_back([&, t, mode = mode] {
+        for (int round = 0; round < rounds; ++round) {
+          start.arrive_and_wait();
+          try {
+            if (mode == Mode::Own) {
+              Snapshot snapshot;
+              clients[t]->fetchSnapshot(decoder, snapshot);
+            } else {
+              shared.get();
+            }
+          } catch (const std::exception&) {
+            errors.fetch_add(1, std::memory_order_relaxed);
+          }
+          start.arrive_and_wait();
+        }
+      });
+    }
+    std::chrono::nanoseconds busy{0};
+    for (int round = 0; round < rounds; ++round) {
+      start.arrive_and_wait();
+      const auto begun = Clock::now();
+      start.arrive_and_wait();
+      busy += Clock::now() - begun;
+    }
+    for (std::thread& caller : callers) caller.join();
+    const std::uint64_t requests =
+        mode == Mode::Own ? threads * rounds : shared.stats().fetches;
+    fmt::print("{:<20}{:>16.2f}{:>12.2f}{:>12}\n", name,
+               static_cast<double>(requests) / rounds,
+               std::chrono::duration<double, std::milli>(busy).count() /
+                   rounds,
+               errors.load());
+  }
+  return 0;
+}
+
+// TLS handshake time of a connection starting cold against one resuming a
+// session: within one process (a handle whose connections are not reused,
+// so each transfer reconnects from its own session cache), and across
+// processes, a fresh handle seeded with the sessions the previous one
+// exported, which is what --conn-cache carries from one --once run to
+// the next. The last needs a libcurl with SSLS-EXPORT; without one --once
+// keeps only the address cache, and that row says so.
+int benchTls(const BenchOptions& options) {
+  if (options.url.rfind("https://", 0) != 0) {
+    fmt::print(fg(fmt::color::red),
+               "tls needs an https --url to a local server, e.g. "
+               "tools/standin_server.py --tls cert.pem key.pem\n");
+    return 1;
+  }
+  const int runs = 20;
+  auto median = [](std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+  };
+  struct Result {
+    double handshake = 0;
+    double total = 0;
+  };
+  // `run` does one transfer and returns its handle's timings; the first
+  // call primes sessions (and the server) and is not counted.
+  auto measure = [&](auto&& run) {
+    std::vector<double> handshake;
+    std::vector<double> total;
+    for (int i = 0; i < runs + 1; ++i) {
+      const TransferTimings t = run();
+      if (i == 0) continue;
+      handshake.push_back(t.tls - t.connect);
+      total.push_back(t.total);
+    }
+    return Result{median(handshake), median(total)};
+  };
+  auto report = [](const char* name, const Result& result) {
+    fmt::print("{:<28}{:>13.2f} ms{:>13.2f} ms\n", name, result.handshake,
+               result.total);
+  };
+
+  fmt::print("{} connections each against {}\n", runs, options.url);
+  fmt::print("{:<28}{:>16}{:>16}\n", "start", "handshake p50",
+             "transfer p50");
+  Result full;
+  Result resumed;
+  try {
+    full = measure([&] {
+      CurlHandler handle;
+      handle.setUrl(options.url);
+      handle.fetch();
+      return handle.timings();
+    });
+    report("full handshake", full);
+
+    CurlHandler reconnecting;
+    reconnecting.setUrl(options.url);
+    reconnecting.setConnectionReuse(false);
+    resumed = measure([&] {
+      reconnecting.fetch();
+      return reconnecting.timings();
+    });
+    report("resumed, same process", resumed);
+
+    if (CurlHandler::tlsSessionsSupported()) {
+      std::vector<TlsSession> carried;
+      std::size_t imported = 0;
+      const Result acrossProcesses = measure([&] {
+        CurlHandler handle;
+        handle.setUrl(options.url);
+        imported += handle.importTlsSessions(carried);
+        handle.fetch();
+        carried = handle.exportTlsSessions();
+        return handle.timings();
+      });
+      report("resumed, next process", acrossProcesses);
+      fmt::print("{:.1f} sessions imported per start\n",
+                 static_cast<double>(imported) / (runs + 1));
+    } else {
+      fmt::print("{:<28}  not available: this libcurl cannot export TLS "
+                 "sessions (needs 8.12+ with SSLS-EXPORT), so --once "
+                 "keeps only the address cache\n",
+                 "resumed, next process");
+    }
+  } catch (const std::exception& e) {
+    fmt::print(fg(fmt::color::red), "{}\n", e.what());
+    return 1;
+  }
+  fmt::print("Resuming saves {:.2f} ms of handshake per connection\n",
+             full.handshake - resumed.handshake);
+  return 0;
+}
+
+// Cold start to first price, measured from outside: each run is a fresh
+// process doing `--once` against --url, so it covers exec, dynamic
+// loading, curl/TLS init, DNS, connect and the first decode.
+int benchStartup(const BenchOptions& options) {
+  if (options.url == BitCoin::DEFAULT_URL) {
+    fmt::print(fg(fmt::color::red),
+               "startup needs --url pointing at a local server, e.g. "
+               "tools/standin_server.py\n");
+    return 1;
+  }
+#ifdef _WIN32
+  const std::string devNull = "NUL";
+#else
+  const std::string devNull = "/dev/null";
+#endif
+  const std::string command = fmt::format(
+      "\"{}\" --once --format ndjson --output {} --url \"{}\"", options.self,
+      devNull, options.url);
+  const int runs = 20;
+  std::vector<double> ms;
+  for (int run = 0; run < runs + 1; ++run) {
+    const auto start = Clock::now();
+    if (std::system(command.c_str()) != 0) {
+      fmt::print(fg(fmt::color::red), "Run failed: {}\n", command);
+      return 1;
+    }
+    const double elapsed =
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count();
+    if (run > 0) ms.push_back(elapsed);  // first run warms the page cache
+  }
+  std::sort(ms.begin(), ms.end());
+  double sum = 0;
+  for (double v : ms) sum += v;
+  fmt::print("Startup to first price, {} runs of --once against {}\n", runs,
+             options.url);
+  fmt::print("  min    {:8.2f} ms\n", ms.front());
+  fmt::print("  median {:8.2f} ms\n", ms[ms.size() / 2]);
+  fmt::print("  mean   {:8.2f} ms\n", sum / static_cast<double>(ms.size()));
+  fmt::print("  max    {:8.2f} ms\n", ms.back());
+  return 0;
+}
+
+// Replayed payloads fanned out over TaskPools of 1, 2, 4 ... N workers.
+// Each task is what one provider and its consumers cost per tick: decode
+// plus a full cross-rate recompute.
+int benchPool(const BenchOptions& options) {
+  std::vector<std::string> payloads;
+  if (!options.replay.empty()) {
+    if (!readReplay(options.replay, payloads)) return 1;
+  } else {
+    for (std::size_t i = 0; i < 64; ++i) {
+      payloads.push_back(syntheticTicker(100 + i));
+    }
+  }
+  if (payloads.empty()) {
+    fmt::print(fg(fmt::color::red), "No payloads to replay\n");
+    return 1;
+  }
+
+  std::size_t maxWorkers = options.workers;
+  if (maxWorkers == 0) maxWorkers = std::thread::hardware_concurrency();
+  if (maxWorkers == 0) maxWorkers = 1;
+  std::vector<std::size_t> sizes;
+  for (std::size_t n = 1; n < maxWorkers; n *= 2) sizes.push_back(n);
+  sizes.push_back(maxWorkers);
+
+  const TickerDecoder decoder;
+  fmt::print("Task pool, {} payloads per round ({}), decode + cross rates\n",
+             payloads.size(), options.replay.empty() ? "synthetic" : "replay");
+  fmt::print("{:<10}{:>16}{:>12}\n", "workers", "payloads/s", "speedup");
+  double baseline = 0;
+  for (std::size_t workers : sizes) {
+    TaskPool pool(workers);
+    std::vector<CrossRateEngine> engines(payloads.size());
+    const double ns = nsPerRun(
+        [&] {
+          TaskGroup group(pool);
+          for (std::size_t i = 0; i < payloads.size(); ++i) {
+            group.run([&, i] {
+              const Snapshot snapshot = decoder.decode(payloads[i]);
+              engines[i].compute(snapshot);
+            });
+          }
+          group.wait();
+        },
+        5);
+    const double rate = static_cast<double>(payloads.size()) / ns * 1e9;
+    if (baseline == 0) baseline = rate;
+    fmt::print("{:<10}{:>16.0f}{:>11.2f}x\n", workers, rate, rate / baseline);
+  }
+  return 0;
+}
+
+// Reader threads (1, 2, 4 ... N) polling the latest snapshot as fast as
+// they can while a writer publishes a new one every millisecond, through
+// a mutex-guarded shared_ptr, std::atomic<std::shared_ptr> and RcuCell.
+// The first two write a shared reference count (and, in libstdc++, take a
+// lock bit) on every read; RcuCell readers only touch their own slot.
+int benchReaders(const BenchOptions& options) {
+  std::size_t maxReaders = options.workers;
+  if (maxReaders == 0) maxReaders = std::thread::hardware_concurrency();
+  if (maxReaders == 0) maxReaders = 1;
+  std::vector<std::size_t> sizes;
+  for (std::size_t n = 1; n < maxReaders; n *= 2) sizes.push_back(n);
+  sizes.push_back(maxReaders);
+
+  const TickerDecoder decoder;
+  std::vector<Snapshot> versions;
+  for (std::uint64_t tick = 0; tick < 16; ++tick) {
+    versions.push_back(decoder.decode(syntheticTicker(100, tick)));
+  }
+
+  // Runs `read` on `readers` threads for 200ms while `write(k)` publishes
+  // version k every millisecond; returns reads per second.
+  auto measure = [&](std::size_t readers, auto&& read, auto&& write) {
+    std::atomic<bool> done{false};
+    std::atomic<std::uint64_t> reads{0};
+    std::barrier start(static_cast<std::ptrdiff_t>(readers) + 2);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < readers; ++t) {
+      threads.emplace_back([&] {
+        auto state = read.prepare();
+        std::uint64_t count = 0;
+        volatile std::int64_t sink = 0;
+        start.arrive_and_wait();
+        while (!done.load(std::memory_order_relaxed)) {
+          sink = read(state);
+          ++count;
+        }
+        static_cast<void>(sink);  // a volatile read: the stores count
+        reads.fetch_add(count, std::memory_order_relaxed);
+      });
+    }
+    threads.emplace_back([&] {
+      start.arrive_and_wait();
+      for (std::size_t k = 0; !done.load(std::memory_order_relaxed); ++k) {
+        write(versions[k % versions.size()]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+    start.arrive_and_wait();
+    const auto begun = Clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    done.store(true, std::memory_order_relaxed);
+    for (std::thread& thread : threads) thread.join();
+    const double seconds =
+        std::chrono::duration<double>(Clock::now() - begun).count();
+    return static_cast<double>(reads.load()) / seconds;
+  };
+
+  struct MutexRead {
+    std::mutex& lock;
+    std::shared_ptr<const Snapshot>& latest;
+    int prepare() const { return 0; }
+    std::int64_t operator()(int) const {
+      std::shared_ptr<const Snapshot> snapshot;
+      {
+        std::lock_guard<std::mutex> guard(this->lock);
+        snapshot = this->latest;
+      }
+      return snapshot->last[0].cents();
+    }
+  };
+  struct AtomicRead {
+    std::atomic<std::shared_ptr<const Snapshot>>& latest;
+    int prepare() const { return 0; }
+    std::int64_t operator()(int) const {
+      return this->latest.load(std::memory_order_acquire)->last[0].cents();
+    }
+  };
+  struct RcuRead {
+    RcuCell<Snapshot>& cell;
+    RcuCell<Snapshot>::Reader prepare() const { return this->cell.reader(); }
+    std::int64_t operator()(const RcuCell<Snapshot>::Reader& reader) const {
+      return reader.read()->last[0].cents();
+    }
+  };
+
+  fmt::print("Latest-snapshot reads/s, writer publishing every 1ms\n");
+  fmt::print("{:<10}{:>16}{:>16}{:>16}{:>10}\n", "readers", "mutex",
+             "atomic<shared>", "RcuCell", "rcu/mutex");
+  for (std::size_t readers : sizes) {
+    std::mutex lock;
+    std::shared_ptr<const Snapshot> guarded =
+        std::make_shared<Snapshot>(versions[0]);
+    const double mutexRate = measure(
+        readers, MutexRead{lock, guarded}, [&](const Snapshot& next) {
+          auto fresh = std::make_shared<const Snapshot>(next);
+          std::lock_guard<std::mutex> guard(lock);
+          guarded = std::move(fresh);
+        });
+
+    std::atomic<std::shared_ptr<const Snapshot>> shared(
+        std::make_shared<const Snapshot>(versions[0]));
+    const double atomicRate =
+        measure(readers, AtomicRead{shared}, [&](const Snapshot& next) {
+          shared.store(std::make_shared<const Snapshot>(next),
+                       std::memory_order_release);
+        });
+
+    RcuCell<Snapshot> cell(readers);
+    cell.draft() = versions[0];
+    cell.publish();
+    const double rcuRate =
+        measure(readers, RcuRead{cell}, [&](const Snapshot& next) {
+          cell.draft() = next;
+          cell.publish();
+        });
+
+    fmt::print("{:<10}{:>16.0f}{:>16.0f}{:>16.0f}{:>9.1f}x\n", readers,
+               mutexRate, atomicRate, rcuRate, rcuRate / mutexRate);
+  }
+  return 0;
+}
+
+// Cost of one TRACE_SPAN: before Tracer::start() (a relaxed load and a
+// branch) and while recording (two clock reads and a ring write).
+int benchTrace() {
+  if (!Tracer::available()) {
+    fmt::print(
+        "Tracing is compiled out (configure with -DENABLE_TRACING=ON)\n");
+    return 0;
+  }
+  const int spans = 1000;
+  auto burst = [] {
+    for (int i = 0; i < spans; ++i) {
+      TRACE_SPAN("bench");
+    }
+  };
+  const double idle = nsPerRun(burst) / spans;
+  Tracer::start();
+  const double recording = nsPerRun(burst) / spans;
+  const double budget = 50.0;
+  fmt::print("{:<22}{:>12}\n", "span", "ns/span");
+  fmt::print("{:<22}{:>12.2f}\n", "not started", idle);
+  fmt::print("{:<22}{:>12.2f}  {}\n", "recording", recording,
+             recording < budget ? "ok" : "over the 50 ns budget");
+  return 0;
+}
+
+// Peak resident set of the process so far, in bytes; 0 where unknown.
+std::uint64_t peakResidentBytes() {
+#ifdef _WIN32
+  return 0;
+#else
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+  return static_cast<std::uint64_t>(usage.ru_maxrss);  // bytes
+#else
+  return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;  // KiB
+#endif
+#endif
+}
+
+// Validate, decode and render (plus the nlohmann DOM decode up to 100k)
+// on generated tickers of 10 to 1M symbols. Cost per symbol should stay
+// flat; a stage whose ns/symbol at 1M is well above its 1k figure is
+// flagged as superlinear.
+int benchScale() {
+  const std::size_t sizes[] = {10, 1'000, 100'000, 1'000'000};
+  const std::size_t domLimit = 100'000;
+  const TickerDecoder decoder;
+  struct Row {
+    const char* stage;
+    std::size_t symbols;
+    double nsPerSymbol;
+  };
+  std::vector<Row> rows;
+
+  fmt::print("{:>9} {:>10}  {:<9}{:>12}{:>12}{:>12}\n", "symbols", "payload",
+             "stage", "ms/run", "ns/symbol", "MB alloc");
+  for (std::size_t symbols : sizes) {
+    std::string payload;
+    const double generateNs = nsPerRun(
+        [&] { payload = syntheticTicker(symbols); }, 1);
+    const std::string_view view = BitCoin::validateAndCleanJson(payload);
+    Snapshot snapshot = decoder.decode(view);
+
+    auto report = [&](const char* stage, double ns, std::uint64_t bytes) {
+      const double perSymbol = ns / static_cast<double>(symbols);
+      rows.push_back({stage, symbols, perSymbol});
+      fmt::print("{:>9} {:>9.1f}K  {:<9}{:>12.3f}{:>12.1f}{:>12.2f}\n",
+                 symbols, static_cast<double>(payload.size()) / 1024.0, stage,
+                 ns / 1e6, perSymbol, static_cast<double>(bytes) / 1048576.0);
+    };
+    // Bytes one fresh run allocates, outside the timed loop.
+    auto allocated = [](auto&& fn) {
+      const std::uint64_t before = globalAllocatedBytes();
+      fn();
+      return globalAllocatedBytes() - before;
+    };
+
+    report("generate", generateNs,
+           allocated([&] { syntheticTicker(symbols).size(); }));
+    auto validate = [&] { BitCoin::validateAndCleanJson(payload).size(); };
+    report("validate", nsPerRun(validate, 1), allocated(validate));
+    auto decode = [&] {
+      Snapshot fresh;
+      decoder.decode(view, fresh);
+    };
+    report("decode", nsPerRun(decode, 1), allocated(decode));
+    if (symbols <= domLimit) {
+      auto dom = [&] { Snapshot::fromJson(nlohmann::json::parse(view)); };
+      report("dom", nsPerRun(dom, 1), allocated(dom));
+    }
+    auto render = [&] {
+      FrameBuffer frame;
+      renderTable(frame, snapshot, 1, std::chrono::seconds(5));
+    };
+    report("render", nsPerRun(render, 1), allocated(render));
+    fmt::print("{:>9} peak RSS {:.1f} MB\n", "",
+               static_cast<double>(peakResidentBytes()) / 1048576.0);
+  }
+
+  int superlinear = 0;
+  fmt::print("\nns/symbol growth, largest size vs 1k:\n");
+  for (const Row& base : rows) {
+    if (base.symbols != 1'000) continue;
+    const Row* largest = &base;
+    for (const Row& row : rows) {
+      if (std::string_view(row.stage) == base.stage &&
+          row.symbols > largest->symbols) {
+        largest = &row;
+      }
+    }
+    const double growth = largest->nsPerSymbol / base.nsPerSymbol;
+    const bool flagged = growth > 3.0;
+    if (flagged) ++superlinear;
+    fmt::print("  {:<9}{:>8.2f}x at {}  {}\n", base.stage, growth,
+               largest->symbols, flagged ? "SUPERLINEAR" : "ok");
+  }
+  return superlinear == 0 ? 0 : 1;
+}
+
+struct Benchmark {
+  const char* name;
+  int (*run)(const BenchOptions&);
+};
+
+template <int (*Run)()>
+int withoutOptions(const BenchOptions&) {
+  return Run();
+}
+
+constexpr Benchmark BENCHMARKS[] = {
+    {"parse", withoutOptions<benchParse>},
+    {"format", withoutOptions<benchFormat>},
+    {"numbers", withoutOptions<benchNumbers>},
+    {"alloc", benchAlloc},
+    {"alerts", withoutOptions<benchAlerts>},
+    {"sinks", withoutOptions<benchSinks>},
+    {"queue", withoutOptions<benchQueue>},
+    {"startup", benchStartup},
+    {"body", benchBody},
+    {"coalesce", benchCoalesce},
+    {"tls", benchTls},
+    {"pool", benchPool},
+    {"readers", benchReaders},
+    {"trace", withoutOptions<benchTrace>},
+    {"scale", withoutOptions<benchScale>},
+    {"delta", withoutOptions<benchDelta>},
+    {"candles", withoutOptions<benchCandles>},
+};
+}  // namespace
+
+int runBenchmark(std::string_view name, const BenchOptions& options) {
+  for (const Benchmark& benchmark : BENCHMARKS) {
+    if (name == benchmark.name) return benchmark.run(options);
+  }
+  fmt::print(fg(fmt::color::red), "Unknown benchmark '{}' (available: {})\n",
+             name, benchmarkNames());
+  return 1;
+}
+
+std::string benchmarkNames() {
+  std::string names;
+  for (const Benchmark& benchmark : BENCHMARKS) {
+    if (!names.empty()) names += ", ";
+    names += benchmark.name;
+  }
+  return names;
+}
@@ -0,0 +1,144 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/candles.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+std::int64_t lengthMillis(std::size_t resolution) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             CANDLE_RESOLUTIONS[resolution].length)
+      .count();
+}
+
+std::int64_t epochMillis(std::chrono::system_clock::time_point at) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             at.time_since_epoch())
+      .count();
+}
+}  // namespace
+
+std::int64_t Candle::startMillis(std::size_t resolution) const {
+  return static_cast<std::int64_t>(this->bucket) * lengthMillis(resolution);
+}
+
+CandleAggregator::CandleAggregator(std::size_t keep) : keep(keep) {
+  if (keep == 0) {
+    throw std::invalid_argument("Candle history must keep at least one");
+  }
+}
+
+void CandleAggregator::update(const Snapshot& snapshot,
+                              std::vector<ClosedCandle>& out) {
+  this->closeBefore(epochMillis(snapshot.fetchedAt), out);
+  this->mapSymbols(snapshot);
+  const std::uint32_t* ids = this->snapshotIds.data();
+  const Price* last = snapshot.last.data();
+  for (Series& series : this->series) {
+    Candle* open = series.open.data();
+    for (std::size_t i = 0; i < snapshot.size(); ++i) {
+      Candle& candle = open[ids[i]];
+      const Price price = last[i];
+      if (candle.ticks == 0) {
+        candle.open = candle.high = candle.low = candle.close = price;
+        candle.bucket = series.bucket;
+        candle.ticks = 1;
+        continue;
+      }
+      candle.high = std::max(candle.high, price);
+      candle.low = std::min(candle.low, price);
+      candle.close = price;
+      ++candle.ticks;
+    }
+  }
+}
+
+void CandleAggregator::advance(std::chrono::system_clock::time_point now,
+                               std::vector<ClosedCandle>& out) {
+  this->closeBefore(epochMillis(now), out);
+}
+
+void CandleAggregator::closeBefore(std::int64_t millis,
+                                   std::vector<ClosedCandle>& out) {
+  millis = std::max<std::int64_t>(millis, 0);
+  for (std::size_t r = 0; r < CANDLE_RESOLUTION_COUNT; ++r) {
+    Series& series = this->series[r];
+    const auto bucket = static_cast<std::uint32_t>(millis / lengthMillis(r));
+    if (bucket <= series.bucket) continue;
+    this->closeOpen(r, out);
+    series.bucket = bucket;
+  }
+}
+
+void CandleAggregator::closeAll(std::vector<ClosedCandle>& out) {
+  for (std::size_t r = 0; r < CANDLE_RESOLUTION_COUNT; ++r) {
+    this->closeOpen(r, out);
+  }
+}
+
+void CandleAggregator::closeOpen(std::size_t resolution,
+                                 std::vector<ClosedCandle>& out) {
+  Series& series = this->series[resolution];
+  for (std::uint32_t id = 0; id < series.open.size(); ++id) {
+    Candle& candle = series.open[id];
+    if (candle.ticks == 0) continue;
+    out.push_back({id, static_cast<std::uint8_t>(resolution), candle});
+    series.ring[id * this->keep + series.closed[id] % this->keep] = candle;
+    ++series.closed[id];
+    candle.ticks = 0;
+  }
+}
+
+void CandleAggregator::mapSymbols(const Snapshot& snapshot) {
+  if (snapshot.symbolsHash == this->symbolsHash &&
+      snapshot.size() == this->mappedSize) {
+    return;
+  }
+  this->snapshotIds.resize(snapshot.size());
+  for (std::size_t i = 0; i < snapshot.size(); ++i) {
+    const auto [it, added] = this->ids.try_emplace(
+        std::string(snapshot.symbols[i]),
+        static_cast<std::uint32_t>(this->names.size()));
+    if (added) this->names.push_back(it->first);
+    this->snapshotIds[i] = it->second;
+  }
+  for (Series& series : this->series) {
+    series.open.resize(this->names.size());
+    series.ring.resize(this->names.size() * this->keep);
+    series.closed.resize(this->names.size());
+  }
+  this->symbolsHash = snapshot.symbolsHash;
+  this->mappedSize = snapshot.size();
+}
+
+std::optional<std::uint32_t> CandleAggregator::idOf(
+    std::string_view symbol) const {
+  const auto it = this->ids.find(std::string(symbol));
+  if (it == this->ids.end()) return std::nullopt;
+  return it->second;
+}
+
+std::optional<Candle> CandleAggregator::current(std::string_view symbol,
+                                                std::size_t resolution) const {
+  const std::optional<std::uint32_t> id = this->idOf(symbol);
+  if (!id) return std::nullopt;
+  const Candle& candle = this->series.at(resolution).open[*id];
+  if (candle.ticks == 0) return std::nullopt;
+  return candle;
+}
+
+std::vector<Candle> CandleAggregator::recent(std::string_view symbol,
+                                             std::size_t resolution) const {
+  std::vector<Candle> candles;
+  const std::optional<std::uint32_t> id = this->idOf(symbol);
+  if (!id) return candles;
+  const Series& series = this->series.at(resolution);
+  const std::uint32_t closed = series.closed[*id];
+  const std::uint32_t count =
+      std::min<std::uint32_t>(closed, static_cast<std::uint32_t>(this->keep));
+  candles.reserve(count);
+  for (std::uint32_t k = closed - count; k < closed; ++k) {
+    candles.push_back(series.ring[*id * this->keep + k % this->keep]);
+  }
+  return candles;
+}
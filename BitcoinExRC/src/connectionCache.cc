@@ -0,0 +1,240 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/connectionCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "../include/snapshotCache.h"
+
+namespace {
+constexpr std::string_view MAGIC = "BTCXCON3";
+
+std::int64_t epochSeconds() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::uint64_t fnv1a(const unsigned char* data, std::size_t size) {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (std::size_t i = 0; i < size; ++i) {
+    hash = (hash ^ data[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+void put(std::vector<unsigned char>& out, std::uint64_t value, int bytes) {
+  for (int b = 0; b < bytes; ++b) {
+    out.push_back(static_cast<unsigned char>((value >> (8 * b)) & 0xFF));
+  }
+}
+
+void putText(std::vector<unsigned char>& out, std::string_view text,
+             int lengthBytes) {
+  put(out, text.size(), lengthBytes);
+  out.insert(out.end(), text.begin(), text.end());
+}
+
+// Bounds-checked cursor over the file; any overrun marks it failed.
+class Reader {
+ public:
+  Reader(const unsigned char* data, std::size_t size)
+      : at(data), end(data + size) {}
+
+  std::uint64_t get(int bytes) {
+    if (this->end - this->at < bytes) return this->fail();
+    std::uint64_t value = 0;
+    for (int b = bytes; b-- > 0;) value = (value << 8) | this->at[b];
+    this->at += bytes;
+    return value;
+  }
+  std::string text(int lengthBytes) {
+    const std::uint64_t length = this->get(lengthBytes);
+    if (static_cast<std::uint64_t>(this->end - this->at) < length) {
+      this->fail();
+      return {};
+    }
+    std::string value(reinterpret_cast<const char*>(this->at), length);
+    this->at += length;
+    return value;
+  }
+  bool ok() const { return !this->failed; }
+  bool done() const { return this->at == this->end; }
+
+ private:
+  std::uint64_t fail() {
+    this->failed = true;
+    this->at = this->end;
+    return 0;
+  }
+  const unsigned char* at;
+  const unsigned char* end;
+  bool failed = false;
+};
+}  // namespace
+
+ConnectionCache::ConnectionCache(std::string path) : file(std::move(path)) {
+  if (this->file.empty()) {
+    throw std::invalid_argument("Cache path cannot be empty");
+  }
+}
+
+std::string ConnectionCache::defaultPath() {
+  const std::string snapshots = SnapshotCache::defaultPath();
+  if (snapshots.empty()) return {};
+  return (std::filesystem::path(snapshots).parent_path() / "connect.bin")
+      .string();
+}
+
+bool ConnectionCache::load() {
+  this->addresses.clear();
+  this->tls.clear();
+  std::ifstream in(this->file, std::ios::binary);
+  if (!in) return false;
+  const std::vector<unsigned char> bytes{std::istreambuf_iterator<char>(in),
+                                         std::istreambuf_iterator<char>()};
+  if (bytes.size() < HEADER_BYTES ||
+      std::memcmp(bytes.data(), MAGIC.data(), MAGIC.size()) != 0) {
+    return false;
+  }
+  Reader header(bytes.data() + MAGIC.size(), HEADER_BYTES - MAGIC.size());
+  const std::uint64_t addressCount = header.get(4);
+  const std::uint64_t sessionCount = header.get(4);
+  const std::uint64_t checksum = header.get(8);
+  if (checksum != fnv1a(bytes.data() + HEADER_BYTES,
+                        bytes.size() - HEADER_BYTES)) {
+    return false;
+  }
+
+  Reader body(bytes.data() + HEADER_BYTES, bytes.size() - HEADER_BYTES);
+  const std::int64_t now = epochSeconds();
+  std::vector<Address> addresses;
+  for (std::uint64_t i = 0; i < addressCount && body.ok(); ++i) {
+    Address entry;
+    entry.resolved.host = body.text(2);
+    const std::uint64_t count = body.get(2);
+    for (std::uint64_t a = 0; a < count && body.ok(); ++a) {
+      entry.resolved.addresses.push_back(body.text(2));
+    }
+    entry.resolved.port = static_cast<long>(body.get(4));
+    entry.expiresAt = static_cast<std::int64_t>(body.get(8));
+    if (entry.expiresAt > now && !entry.resolved.addresses.empty()) {
+      addresses.push_back(std::move(entry));
+    }
+  }
+  std::vector<TlsSession> sessions;
+  for (std::uint64_t i = 0; i < sessionCount && body.ok(); ++i) {
+    TlsSession session;
+    session.key = body.text(2);
+    session.shmac = body.text(4);
+    session.data = body.text(4);
+    session.validUntil = static_cast<std::int64_t>(body.get(8));
+    if (session.validUntil == 0 || session.validUntil > now) {
+      sessions.push_back(std::move(session));
+    }
+  }
+  if (!body.ok() || !body.done()) return false;
+  this->addresses = std::move(addresses);
+  this->tls = std::move(sessions);
+  return true;
+}
+
+void ConnectionCache::save() const {
+  std::vector<unsigned char> bytes(HEADER_BYTES);
+  for (const Address& entry : this->addresses) {
+    putText(bytes, entry.resolved.host, 2);
+    put(bytes, entry.resolved.addresses.size(), 2);
+    for (const std::string& address : entry.resolved.addresses) {
+      putText(bytes, address, 2);
+    }
+    put(bytes, static_cast<std::uint64_t>(entry.resolved.port), 4);
+    put(bytes, static_cast<std::uint64_t>(entry.expiresAt), 8);
+  }
+  for (const TlsSession& session : this->tls) {
+    putText(bytes, session.key, 2);
+    putText(bytes, session.shmac, 4);
+    putText(bytes, session.data, 4);
+    put(bytes, static_cast<std::uint64_t>(session.validUntil), 8);
+  }
+  std::vector<unsigned char> header;
+  header.insert(header.end(), MAGIC.begin(), MAGIC.end());
+  put(header, this->addresses.size(), 4);
+  put(header, this->tls.size(), 4);
+  put(header,
+      fnv1a(bytes.data() + HEADER_BYTES, bytes.size() - HEADER_BYTES), 8);
+  std::copy(header.begin(), header.end(), bytes.begin());
+
+  const std::filesystem::path target(this->file);
+  std::error_code ec;
+  if (target.has_parent_path()) {
+    std::filesystem::create_directories(target.parent_path(), ec);
+  }
+  // A fresh owner-only file each time: concurrent runs never share a
+  // temporary, and another user cannot plant one to redirect the write.
+  std::string temporary;
+  replaceFile(this->file, bytes.data(), bytes.size(), temporary,
+              "connection cache");
+}
+
+void ConnectionCache::discard() {
+  this->addresses.clear();
+  this->tls.clear();
+  std::remove(this->file.c_str());
+}
+
+std::optional<ResolvedAddress> ConnectionCache::address(
+    const std::string& host, long port) const {
+  const std::int64_t now = epochSeconds();
+  for (const Address& entry : this->addresses) {
+    if (entry.resolved.host == host && entry.resolved.port == port &&
+        entry.expiresAt > now) {
+      return entry.resolved;
+    }
+  }
+  return std::nullopt;
+}
+
+void ConnectionCache::remember(const ResolvedAddress& resolved) {
+  const std::int64_t expiresAt =
+      epochSeconds() +
+      std::chrono::duration_cast<std::chrono::seconds>(ADDRESS_TTL).count();
+  for (Address& entry : this->addresses) {
+    if (entry.resolved.host == resolved.host &&
+        entry.resolved.port == resolved.port) {
+      entry.resolved.addresses = resolved.addresses;
+      entry.expiresAt = expiresAt;
+      return;
+    }
+  }
+  this->addresses.push_back({resolved, expiresAt});
+}
+
+void ConnectionCache::keepSessions(const std::vector<TlsSession>& sessions) {
+  const std::int64_t now = epochSeconds();
+  auto expired = [now](const TlsSession& session) {
+    return session.validUntil != 0 && session.validUntil <= now;
+  };
+  std::erase_if(this->tls, [&](const TlsSession& kept) {
+    return expired(kept) ||
+           std::any_of(sessions.begin(), sessions.end(),
+                       [&](const TlsSession& fresh) {
+                         return fresh.key == kept.key;
+                       });
+  });
+  for (const TlsSession& session : sessions) {
+    if (!expired(session)) this->tls.push_back(session);
+  }
+  if (this->tls.size() > MAX_SESSIONS) {
+    const auto excess =
+        static_cast<std::ptrdiff_t>(this->tls.size() - MAX_SESSIONS);
+    this->tls.erase(this->tls.begin(), this->tls.begin() + excess);
+  }
+}
@@ -0,0 +1,157 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/crossRates.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CROSS_RATES_SSE2 1
+#endif
+
+namespace {
+// dst[j] = src[j] * factor, the inner loop of every matrix row.
+void scaleRow(const double* __restrict src, double factor,
+              double* __restrict dst, std::size_t n) {
+  std::size_t j = 0;
+#if defined(__AVX__)
+  const __m256d f = _mm256_set1_pd(factor);
+  for (; j + 4 <= n; j += 4) {
+    _mm256_storeu_pd(dst + j, _mm256_mul_pd(_mm256_loadu_pd(src + j), f));
+  }
+#elif defined(CROSS_RATES_SSE2)
+  const __m128d f = _mm_set1_pd(factor);
+  for (; j + 2 <= n; j += 2) {
+    _mm_storeu_pd(dst + j, _mm_mul_pd(_mm_loadu_pd(src + j), f));
+  }
+#endif
+  for (; j < n; ++j) dst[j] = src[j] * factor;
+}
+
+double inverseOf(double price) {
+  return price > 0.0 ? 1.0 / price : std::numeric_limits<double>::quiet_NaN();
+}
+}  // namespace
+
+const std::pmr::vector<Price>& CrossRateEngine::source(
+    const Snapshot& snapshot, Field field) {
+  switch (field) {
+    case Field::Buy:
+      return snapshot.buy;
+    case Field::Sell:
+      return snapshot.sell;
+    case Field::Last:
+    default:
+      return snapshot.last;
+  }
+}
+
+bool CrossRateEngine::sameSymbols(const Snapshot& snapshot) const {
+  return std::equal(this->symbols.begin(), this->symbols.end(),
+                    snapshot.symbols.begin(), snapshot.symbols.end(),
+                    [](const std::string& a, const std::pmr::string& b) {
+                      return std::string_view(a) == std::string_view(b);
+                    });
+}
+
+void CrossRateEngine::load(const Snapshot& snapshot) {
+  const std::size_t n = snapshot.size();
+  this->symbols.assign(snapshot.symbols.begin(), snapshot.symbols.end());
+  for (std::size_t f = 0; f < FIELD_COUNT; ++f) {
+    Plane& plane = this->planes[f];
+    const std::pmr::vector<Price>& prices = source(snapshot, static_cast<Field>(f));
+    plane.price.resize(n);
+    plane.inverse.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      plane.price[i] = prices[i].toDouble();
+      plane.inverse[i] = inverseOf(plane.price[i]);
+    }
+    plane.matrix.resize(n * n);
+  }
+}
+
+void CrossRateEngine::refreshRow(Plane& plane, std::size_t base) const {
+  const std::size_t n = this->symbols.size();
+  double* dst = plane.matrix.data() + base * n;
+  scaleRow(plane.price.data(), plane.inverse[base], dst, n);
+  // p * (1 / p) is not always exactly one in floating point.
+  if (plane.price[base] > 0.0) dst[base] = 1.0;
+}
+
+void CrossRateEngine::refreshColumn(Plane& plane, std::size_t quote) const {
+  const std::size_t n = this->symbols.size();
+  const double price = plane.price[quote];
+  for (std::size_t i = 0; i < n; ++i) {
+    plane.matrix[i * n + quote] = price * plane.inverse[i];
+  }
+  if (price > 0.0) plane.matrix[quote * n + quote] = 1.0;
+}
+
+void CrossRateEngine::compute(const Snapshot& snapshot) {
+  this->load(snapshot);
+  for (Plane& plane : this->planes) {
+    for (std::size_t base = 0; base < this->symbols.size(); ++base) {
+      this->refreshRow(plane, base);
+    }
+  }
+}
+
+std::size_t CrossRateEngine::update(const Snapshot& snapshot) {
+  if (!this->sameSymbols(snapshot)) {
+    this->compute(snapshot);
+    return snapshot.size();
+  }
+  this->changedRows.clear();
+  for (std::size_t i = 0; i < snapshot.size(); ++i) {
+    for (std::size_t f = 0; f < FIELD_COUNT; ++f) {
+      if (source(snapshot, static_cast<Field>(f))[i].toDouble() !=
+          this->planes[f].price[i]) {
+        this->changedRows.push_back(i);
+        break;
+      }
+    }
+  }
+  if (!this->changedRows.empty()) this->update(snapshot, this->changedRows);
+  return this->changedRows.size();
+}
+
+void CrossRateEngine::update(const Snapshot& snapshot,
+                             std::span<const std::size_t> changed) {
+  if (!this->sameSymbols(snapshot)) {
+    this->compute(snapshot);
+    return;
+  }
+  for (std::size_t f = 0; f < FIELD_COUNT; ++f) {
+    Plane& plane = this->planes[f];
+    const std::pmr::vector<Price>& prices = source(snapshot, static_cast<Field>(f));
+    for (std::size_t i : changed) {
+      plane.price[i] = prices[i].toDouble();
+      plane.inverse[i] = inverseOf(plane.price[i]);
+    }
+    for (std::size_t i : changed) {
+      this->refreshRow(plane, i);
+      this->refreshColumn(plane, i);
+    }
+  }
+}
+
+double CrossRateEngine::rate(Field field, std::size_t base,
+                             std::size_t quote) const {
+  const std::size_t n = this->symbols.size();
+  if (base >= n || quote >= n) {
+    throw std::out_of_range("Cross rate index out of range");
+  }
+  return this->planes[static_cast<std::size_t>(field)].matrix[base * n + quote];
+}
+
+std::span<const double> CrossRateEngine::row(Field field,
+                                             std::size_t base) const {
+  const std::size_t n = this->symbols.size();
+  if (base >= n) throw std::out_of_range("Cross rate row out of range");
+  const auto& matrix = this->planes[static_cast<std::size_t>(field)].matrix;
+  return {matrix.data() + base * n, n};
+}
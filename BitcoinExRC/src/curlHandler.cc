@@ -1,20 +1,198 @@
 // Copyright(c)2022 Vishal Ahirwar.
 #include "../include/curlHandler.h"
-#include "../include/dataHandler.h"
+#include "../include/trace.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <stdexcept>
 #include <iostream>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
 
-CurlHandler::CurlHandler() : curlptr(curl_easy_init(), deleter) {
-    curl_global_init(CURL_GLOBAL_ALL);
-    
+namespace {
+// Bodies of unknown length grow in steps of at least this much.
+constexpr std::size_t BODY_CHUNK = 64 * 1024;
+// Most a Content-Length header alone may reserve up front.
+constexpr std::size_t MAX_PRESIZE = std::size_t{4} << 20;
+
+// Body buffers handed back through CurlHandler::recycle(), so a transfer
+// whose previous body was moved out (the pipeline) still starts with
+// capacity instead of growing from empty.
+class BodyPool {
+public:
+    std::string acquire() {
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (this->buffers.empty()) return {};
+        std::string buffer = std::move(this->buffers.back());
+        this->buffers.pop_back();
+        return buffer;
+    }
+
+    void release(std::string&& buffer) {
+        if (buffer.capacity() < BODY_CHUNK) return;
+        buffer.clear();
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (this->buffers.size() < MAX_POOLED) this->buffers.push_back(std::move(buffer));
+    }
+
+private:
+    static constexpr std::size_t MAX_POOLED = 8;
+    std::mutex lock;
+    std::vector<std::string> buffers;
+};
+
+BodyPool& bodyPool() {
+    static BodyPool pool;
+    return pool;
+}
+
+// IMF-fixdate, the form Date and Last-Modified take:
+// "Sun, 06 Nov 1994 08:49:37 GMT".
+bool parseHttpDate(std::string_view text, std::chrono::system_clock::time_point& out) {
+    const std::size_t comma = text.find(", ");
+    if (comma == std::string_view::npos) return false;
+    text.remove_prefix(comma + 2);
+    if (text.size() < 20) return false;
+    auto number = [text](std::size_t pos, std::size_t length, int& value) {
+        const char* first = text.data() + pos;
+        const auto [end, ec] = std::from_chars(first, first + length, value);
+        return ec == std::errc{} && end == first + length;
+    };
+    int day = 0, year = 0, hour = 0, minute = 0, second = 0;
+    if (!number(0, 2, day) || !number(7, 4, year) || !number(12, 2, hour) ||
+        !number(15, 2, minute) || !number(18, 2, second)) {
+        return false;
+    }
+    constexpr std::string_view MONTHS = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    const std::size_t month = MONTHS.find(text.substr(3, 3));
+    if (month == std::string_view::npos || month % 3 != 0) return false;
+    const std::chrono::year_month_day date{std::chrono::year{year},
+                                           std::chrono::month{static_cast<unsigned>(month / 3 + 1)},
+                                           std::chrono::day{static_cast<unsigned>(day)}};
+    if (!date.ok()) return false;
+    out = std::chrono::sys_days{date} + std::chrono::hours{hour} +
+          std::chrono::minutes{minute} + std::chrono::seconds{second};
+    return true;
+}
+
+// Value of header `name` in the raw line `line`, if that is the header.
+bool headerValue(std::string_view line, std::string_view name, std::string_view& value) {
+    if (line.size() <= name.size() || line[name.size()] != ':') return false;
+    for (std::size_t i = 0; i < name.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(line[i])) != name[i]) return false;
+    }
+    value = line.substr(name.size() + 1);
+    const std::size_t first = value.find_first_not_of(" \t");
+    value.remove_prefix(first == std::string_view::npos ? value.size() : first);
+    const std::size_t last = value.find_last_not_of(" \t\r\n");
+    value = value.substr(0, last == std::string_view::npos ? 0 : last + 1);
+    return true;
+}
+}  // namespace
+
+std::size_t CurlHandler::onHeader(char *buffer, std::size_t size, std::size_t count,
+                                  void *userData) {
+    Body& body = *static_cast<Body*>(userData);
+    const std::string_view line(buffer, size * count);
+    std::string_view value;
+    if (line.rfind("HTTP/", 0) == 0) {
+        // A new response (after a redirect or 100-continue) starts over.
+        body.expected = 0;
+        body.encoded = false;
+        body.sized = false;
+        body.date.reset();
+        body.lastModified.reset();
+        body.age = std::chrono::seconds{0};
+    } else if (headerValue(line, "content-length", value)) {
+        std::size_t length = 0;
+        const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), length);
+        if (ec == std::errc{} && end == value.data() + value.size()) {
+            body.expected = length;
+            if (body.maxBody != 0 && length > body.maxBody) {
+                body.tooLarge = true;
+                return 0;  // aborts the transfer before the body
+            }
+        }
+    } else if (headerValue(line, "content-encoding", value)) {
+        body.encoded = !value.empty() && value != "identity";
+    } else if (headerValue(line, "date", value)) {
+        std::chrono::system_clock::time_point at;
+        if (parseHttpDate(value, at)) body.date = at;
+    } else if (headerValue(line, "last-modified", value)) {
+        std::chrono::system_clock::time_point at;
+        if (parseHttpDate(value, at)) body.lastModified = at;
+    } else if (headerValue(line, "age", value)) {
+        long long seconds = 0;
+        const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), seconds);
+        if (ec == std::errc{} && end == value.data() + value.size() && seconds >= 0) {
+            body.age = std::chrono::seconds{seconds};
+        }
+    }
+    return size * count;
+}
+
+std::size_t CurlHandler::onBody(char *buffer, std::size_t size, std::size_t count,
+                                void *userData) {
+    Body& body = *static_cast<Body*>(userData);
+    const std::size_t bytes = size * count;
+    // Nothing may throw through libcurl's C frames: a failed allocation
+    // aborts the transfer instead and fetch() reports it.
+    try {
+        if (!body.sized) {
+            body.sized = true;
+            body.data.clear();
+            // An exact Content-Length presizes the buffer once; a compressed
+            // one still says the body is at least that long. The header is
+            // only the server's word, so past MAX_PRESIZE the chunked growth
+            // below follows the bytes that actually arrive.
+            const std::size_t presize = std::min(body.expected, MAX_PRESIZE);
+            if (presize > body.data.capacity()) body.data.reserve(presize);
+        }
+        const std::size_t needed = body.data.size() + bytes;
+        if (body.maxBody != 0 && needed > body.maxBody) {
+            body.tooLarge = true;
+            return 0;
+        }
+        if (needed > body.data.capacity()) {
+            // Unknown (or wrong) length: grow by 1.5x in whole chunks rather
+            // than once per network read.
+            std::size_t capacity = std::max(needed, body.data.capacity() + body.data.capacity() / 2);
+            capacity = (capacity + BODY_CHUNK - 1) / BODY_CHUNK * BODY_CHUNK;
+            if (body.maxBody != 0) capacity = std::min(capacity, std::max(body.maxBody, needed));
+            body.data.reserve(capacity);
+            ++body.growths;
+        }
+        body.data.append(buffer, bytes);
+    } catch (const std::exception&) {  // bad_alloc, length_error
+        body.outOfMemory = true;
+        return 0;
+    }
+    return bytes;
+}
+
+CURL *CurlHandler::createHandle() {
+    static std::once_flag globalInit;
+    std::call_once(globalInit, [] {
+        if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+            throw std::runtime_error("Failed to initialize libcurl");
+        }
+    });
+    return curl_easy_init();
+}
+
+CurlHandler::CurlHandler() : curlptr(createHandle(), deleter) {
     if (!this->curlptr) {
         throw std::runtime_error("Failed to initialize curl");
     }
     
     // Basic curl options
     curl_easy_setopt(this->curlptr.get(), CURLOPT_SSL_VERIFYPEER, 0L);
-    curl_easy_setopt(this->curlptr.get(), CURLOPT_WRITEFUNCTION, dataHandler);
-    curl_easy_setopt(this->curlptr.get(), CURLOPT_WRITEDATA, &(this->data));
+    curl_easy_setopt(this->curlptr.get(), CURLOPT_WRITEFUNCTION, onBody);
+    curl_easy_setopt(this->curlptr.get(), CURLOPT_WRITEDATA, &(this->body));
+    curl_easy_setopt(this->curlptr.get(), CURLOPT_HEADERFUNCTION, onHeader);
+    curl_easy_setopt(this->curlptr.get(), CURLOPT_HEADERDATA, &(this->body));
     
     // Timeout settings
     curl_easy_setopt(this->curlptr.get(), CURLOPT_TIMEOUT, 30L);
@@ -38,17 +216,141 @@ void CurlHandler::setUrl(const std::string &url) {
     curl_easy_setopt(this->curlptr.get(), CURLOPT_URL, url.c_str());
 }
 
+void CurlHandler::setResolvedAddress(const std::string &host, long port,
+                                     const std::vector<std::string> &addresses) {
+    if (addresses.empty()) {
+        curl_easy_setopt(this->curlptr.get(), CURLOPT_RESOLVE, static_cast<curl_slist *>(nullptr));
+        this->resolve.reset();
+        return;
+    }
+    // host:port:addr1,addr2,... with IPv6 addresses in brackets.
+    std::string entry = host + ":" + std::to_string(port) + ":";
+    for (std::size_t i = 0; i < addresses.size(); ++i) {
+        if (i != 0) entry += ',';
+        const bool ipv6 = addresses[i].find(':') != std::string::npos;
+        entry += ipv6 ? "[" + addresses[i] + "]" : addresses[i];
+    }
+    this->resolve.reset(curl_slist_append(nullptr, entry.c_str()));
+    curl_easy_setopt(this->curlptr.get(), CURLOPT_RESOLVE, this->resolve.get());
+}
+
+TransferTimings CurlHandler::timings() const {
+    TransferTimings t;
+    auto ms = [this](CURLINFO info) {
+        curl_off_t us = 0;
+        curl_easy_getinfo(this->curlptr.get(), info, &us);
+        return static_cast<double>(us) / 1000.0;
+    };
+    t.dns = ms(CURLINFO_NAMELOOKUP_TIME_T);
+    t.connect = ms(CURLINFO_CONNECT_TIME_T);
+    t.tls = ms(CURLINFO_APPCONNECT_TIME_T);
+    t.firstByte = ms(CURLINFO_STARTTRANSFER_TIME_T);
+    t.total = ms(CURLINFO_TOTAL_TIME_T);
+    return t;
+}
+
+void CurlHandler::setConnectionReuse(bool reuse) {
+    curl_easy_setopt(this->curlptr.get(), CURLOPT_FORBID_REUSE, reuse ? 0L : 1L);
+}
+
+bool CurlHandler::tlsSessionsSupported() {
+#if LIBCURL_VERSION_NUM >= 0x080c00
+    // The API is there from 8.12 on, but it is a build option of libcurl's;
+    // without it export/import fail with CURLE_NOT_BUILT_IN.
+    static const bool built = [] {
+        const curl_version_info_data *info = curl_version_info(CURLVERSION_NOW);
+        for (const char *const *name = info->feature_names; name && *name; ++name)
+            if (std::string_view(*name) == "SSLS-EXPORT") return true;
+        return false;
+    }();
+    return built;
+#else
+    return false;
+#endif
+}
+
+std::vector<TlsSession> CurlHandler::exportTlsSessions() const {
+    std::vector<TlsSession> sessions;
+#if LIBCURL_VERSION_NUM >= 0x080c00
+    if (!tlsSessionsSupported()) return sessions;
+    auto collect = [](CURL *, void *userData, const char *key, const unsigned char *shmac, std::size_t shmacLength,
+                      const unsigned char *data, std::size_t dataLength, curl_off_t validUntil, int, const char *,
+                      std::size_t) -> CURLcode {
+        auto &out = *static_cast<std::vector<TlsSession> *>(userData);
+        TlsSession &session = out.emplace_back();
+        session.key = key ? key : "";
+        session.shmac.assign(reinterpret_cast<const char *>(shmac), shmacLength);
+        session.data.assign(reinterpret_cast<const char *>(data), dataLength);
+        session.validUntil = static_cast<std::int64_t>(validUntil);
+        return CURLE_OK;
+    };
+    if (curl_easy_ssls_export(this->curlptr.get(), collect, &sessions) != CURLE_OK) sessions.clear();
+#endif
+    return sessions;
+}
+
+std::size_t CurlHandler::importTlsSessions(const std::vector<TlsSession> &sessions) {
+    std::size_t imported = 0;
+#if LIBCURL_VERSION_NUM >= 0x080c00
+    if (!tlsSessionsSupported()) return 0;
+    const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::system_clock::now().time_since_epoch()).count();
+    for (const TlsSession &session : sessions) {
+        if (session.validUntil != 0 && session.validUntil <= now) continue;
+        const CURLcode res = curl_easy_ssls_import(
+            this->curlptr.get(), session.key.empty() ? nullptr : session.key.c_str(),
+            reinterpret_cast<const unsigned char *>(session.shmac.data()), session.shmac.size(),
+            reinterpret_cast<const unsigned char *>(session.data.data()), session.data.size());
+        if (res == CURLE_OK) ++imported;
+    }
+#else
+    (void)sessions;
+#endif
+    return imported;
+}
+
 CURLcode CurlHandler::fetch() {
-    // Clear previous data
-    this->data.clear();
+    // Clear previous data, keeping its capacity (or a pooled buffer's if
+    // the last body was taken).
+    if (this->body.data.capacity() < BODY_CHUNK) {
+        std::string pooled = bodyPool().acquire();
+        if (pooled.capacity() > this->body.data.capacity()) this->body.data = std::move(pooled);
+    }
+    this->body.data.clear();
+    this->body.expected = 0;
+    this->body.encoded = false;
+    this->body.sized = false;
+    this->body.tooLarge = false;
+    this->body.outOfMemory = false;
+    this->body.growths = 0;
+    this->body.date.reset();
+    this->body.lastModified.reset();
+    this->body.age = std::chrono::seconds{0};
+    this->lastFreshness = {};
+    const auto localStart = std::chrono::system_clock::now();
     
     if (!this->curlptr) {
         throw std::runtime_error("Curl handle not initialized");
     }
     
     // Perform the request
-    CURLcode res = curl_easy_perform(this->curlptr.get());
+    CURLcode res;
+    {
+        TRACE_SPAN("curl perform");
+        res = curl_easy_perform(this->curlptr.get());
+    }
     
+    if (this->body.tooLarge) {
+        this->body.data.clear();
+        throw std::runtime_error("Response body exceeds the " + std::to_string(this->body.maxBody) +
+                                 " byte limit; transfer aborted");
+    }
+    if (this->body.outOfMemory) {
+        this->body.data.clear();
+        this->body.data.shrink_to_fit();
+        throw std::runtime_error("Out of memory buffering the response body; transfer aborted");
+    }
+
     if (res != CURLE_OK) {
         std::string error = "Curl request failed: " + std::string(curl_easy_strerror(res));
         
@@ -86,29 +388,49 @@ CURLcode CurlHandler::fetch() {
     }
     
     // Validate that we received data
-    if (this->data.empty()) {
+    if (this->body.data.empty()) {
         throw std::runtime_error("Received empty response from server");
     }
-    
-    // Get additional info for debugging
-    double total_time = 0;
-    curl_easy_getinfo(this->curlptr.get(), CURLINFO_TOTAL_TIME, &total_time);
-    
-    size_t download_size = 0;
-    curl_easy_getinfo(this->curlptr.get(), CURLINFO_SIZE_DOWNLOAD_T, &download_size);
-    
-    // Log debug info if response seems suspicious
-    if (this->data.length() > 2700 && this->data.length() < 2800) {
-        std::cerr << "Debug - Response size: " << this->data.length() 
-                  << ", Download time: " << total_time << "s" 
-                  << ", Curl reported size: " << download_size << std::endl;
-    }
+
+    this->lastFreshness = this->estimateFreshness(localStart);
     
     return res;
 }
 
-const std::string CurlHandler::getFetchedData() const { 
-    return this->data; 
+Freshness CurlHandler::estimateFreshness(std::chrono::system_clock::time_point localStart) const {
+    curl_off_t requestSentUs = 0;
+    curl_off_t firstByteUs = 0;
+    curl_easy_getinfo(this->curlptr.get(), CURLINFO_PRETRANSFER_TIME_T, &requestSentUs);
+    curl_easy_getinfo(this->curlptr.get(), CURLINFO_STARTTRANSFER_TIME_T, &firstByteUs);
+    const auto sent = localStart + std::chrono::microseconds(requestSentUs);
+    const auto firstByte = localStart + std::chrono::microseconds(firstByteUs);
+
+    Freshness freshness;
+    freshness.oneWay = (firstByte - sent) / 2;
+    const auto midpoint = sent + freshness.oneWay;
+    freshness.sourceAt = midpoint - this->body.age;
+    if (this->body.date) {
+        // Date is truncated to the second; take the middle of it.
+        freshness.serverDated = true;
+        freshness.skew = *this->body.date + std::chrono::milliseconds(500) - midpoint;
+        if (this->body.lastModified) {
+            const auto modified = *this->body.lastModified - freshness.skew;
+            freshness.sourceAt = std::min(freshness.sourceAt, modified);
+        }
+    }
+    return freshness;
+}
+
+const std::string& CurlHandler::getFetchedData() const { 
+    return this->body.data; 
+}
+
+std::string CurlHandler::takeFetchedData() {
+    return std::move(this->body.data);
+}
+
+void CurlHandler::recycle(std::string&& body) {
+    bodyPool().release(std::move(body));
 }
 
 // Additional method to get response info for debugging
@@ -132,12 +454,12 @@ void CurlHandler::printDebugInfo() const {
     std::cout << "Total Time: " << total_time << "s" << std::endl;
     std::cout << "Download Time: " << download_time << "s" << std::endl;
     std::cout << "Downloaded Size: " << download_size << " bytes" << std::endl;
-    std::cout << "Actual Data Size: " << this->data.length() << " bytes" << std::endl;
+    std::cout << "Actual Data Size: " << this->body.data.length() << " bytes" << std::endl;
     std::cout << "Content Type: " << (content_type ? content_type : "unknown") << std::endl;
     
-    if (this->data.length() > 50) {
-        std::cout << "First 50 chars: " << this->data.substr(0, 50) << std::endl;
-        std::cout << "Last 50 chars: " << this->data.substr(this->data.length() - 50) << std::endl;
+    if (this->body.data.length() > 50) {
+        std::cout << "First 50 chars: " << this->body.data.substr(0, 50) << std::endl;
+        std::cout << "Last 50 chars: " << this->body.data.substr(this->body.data.length() - 50) << std::endl;
     }
     std::cout << "======================" << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,141 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/deltaEncoder.h"
+
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DELTA_ENCODER_SSE2 1
+#endif
+
+namespace {
+static_assert(sizeof(Price) == sizeof(std::int64_t),
+              "Price arrays are compared as raw 64-bit lanes");
+
+constexpr std::size_t BLOCK = 8;
+
+// The four price arrays of one side of the diff.
+struct Columns {
+  const Price* m15;
+  const Price* last;
+  const Price* buy;
+  const Price* sell;
+};
+
+// True if any of the BLOCK symbols starting at `base` has a different
+// price in any field: XOR both sides, OR everything together, test once.
+bool blockDiffers(const Columns& a, const Columns& b, std::size_t base) {
+#if defined(__AVX2__)
+  __m256i acc = _mm256_setzero_si256();
+  for (const auto& [x, y] :
+       {std::pair{a.m15, b.m15}, std::pair{a.last, b.last},
+        std::pair{a.buy, b.buy}, std::pair{a.sell, b.sell}}) {
+    for (std::size_t k = 0; k < BLOCK; k += 4) {
+      const auto* px = reinterpret_cast<const __m256i*>(x + base + k);
+      const auto* py = reinterpret_cast<const __m256i*>(y + base + k);
+      acc = _mm256_or_si256(acc, _mm256_xor_si256(_mm256_loadu_si256(px),
+                                                  _mm256_loadu_si256(py)));
+    }
+  }
+  return !_mm256_testz_si256(acc, acc);
+#elif defined(DELTA_ENCODER_SSE2)
+  __m128i acc = _mm_setzero_si128();
+  for (const auto& [x, y] :
+       {std::pair{a.m15, b.m15}, std::pair{a.last, b.last},
+        std::pair{a.buy, b.buy}, std::pair{a.sell, b.sell}}) {
+    for (std::size_t k = 0; k < BLOCK; k += 2) {
+      const auto* px = reinterpret_cast<const __m128i*>(x + base + k);
+      const auto* py = reinterpret_cast<const __m128i*>(y + base + k);
+      acc = _mm_or_si128(acc, _mm_xor_si128(_mm_loadu_si128(px),
+                                            _mm_loadu_si128(py)));
+    }
+  }
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) !=
+         0xFFFF;
+#else
+  std::int64_t acc = 0;
+  for (std::size_t i = base; i < base + BLOCK; ++i) {
+    acc |= (a.m15[i].cents() ^ b.m15[i].cents()) |
+           (a.last[i].cents() ^ b.last[i].cents()) |
+           (a.buy[i].cents() ^ b.buy[i].cents()) |
+           (a.sell[i].cents() ^ b.sell[i].cents());
+  }
+  return acc != 0;
+#endif
+}
+
+std::uint8_t changedFields(const Columns& a, const Columns& b, std::size_t i) {
+  return static_cast<std::uint8_t>(
+      (a.m15[i] != b.m15[i] ? DELTA_M15 : 0) |
+      (a.last[i] != b.last[i] ? DELTA_LAST : 0) |
+      (a.buy[i] != b.buy[i] ? DELTA_BUY : 0) |
+      (a.sell[i] != b.sell[i] ? DELTA_SELL : 0));
+}
+}  // namespace
+
+DeltaEncoder::DeltaEncoder(std::size_t keyframeEvery)
+    : keyframeEvery(keyframeEvery) {}
+
+void DeltaEncoder::keyframe(const Snapshot& next) {
+  const std::size_t n = next.size();
+  this->symbolCount = n;
+  this->symbolsHash = next.symbolsHash;
+  this->m15.assign(next.m15.begin(), next.m15.end());
+  this->last.assign(next.last.begin(), next.last.end());
+  this->buy.assign(next.buy.begin(), next.buy.end());
+  this->sell.assign(next.sell.begin(), next.sell.end());
+  this->frame.keyframe = true;
+  this->frame.ids.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    this->frame.ids[i] = static_cast<std::uint32_t>(i);
+  }
+  this->frame.fields.assign(n, DELTA_ALL);
+  this->sinceKeyframe = 0;
+  this->primed = true;
+}
+
+const DeltaFrame& DeltaEncoder::encode(const Snapshot& next) {
+  ++this->sinceKeyframe;
+  if (!this->primed ||
+      (this->keyframeEvery != 0 &&
+       this->sinceKeyframe >= this->keyframeEvery) ||
+      next.size() != this->symbolCount ||
+      next.symbolsHash != this->symbolsHash) {
+    this->keyframe(next);
+    return this->frame;
+  }
+
+  this->frame.keyframe = false;
+  this->frame.ids.clear();
+  this->frame.fields.clear();
+  const Columns before{this->m15.data(), this->last.data(), this->buy.data(),
+                       this->sell.data()};
+  const Columns after{next.m15.data(), next.last.data(), next.buy.data(),
+                      next.sell.data()};
+  const std::size_t n = next.size();
+  auto scan = [&](std::size_t from, std::size_t to) {
+    for (std::size_t i = from; i < to; ++i) {
+      if (const std::uint8_t mask = changedFields(before, after, i)) {
+        this->frame.ids.push_back(static_cast<std::uint32_t>(i));
+        this->frame.fields.push_back(mask);
+      }
+    }
+  };
+  std::size_t base = 0;
+  for (; base + BLOCK <= n; base += BLOCK) {
+    if (blockDiffers(before, after, base)) scan(base, base + BLOCK);
+  }
+  scan(base, n);
+
+  // Only what changed needs copying into the reference.
+  for (std::uint32_t i : this->frame.ids) {
+    this->m15[i] = next.m15[i];
+    this->last[i] = next.last[i];
+    this->buy[i] = next.buy[i];
+    this->sell[i] = next.sell[i];
+  }
+  return this->frame;
+}
@@ -0,0 +1,93 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/dnsPrefetch.h"
+
+#include <algorithm>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#endif
+
+std::optional<ResolvedAddress> parseUrlHost(const std::string& url) {
+  const auto scheme = url.find("://");
+  if (scheme == std::string::npos) return std::nullopt;
+  ResolvedAddress result;
+  result.port = url.compare(0, scheme, "https") == 0 ? 443 : 80;
+
+  const std::size_t start = scheme + 3;
+  const std::size_t end = url.find_first_of("/?#", start);
+  std::string authority = url.substr(start, end - start);
+  if (const auto at = authority.rfind('@'); at != std::string::npos) {
+    authority.erase(0, at + 1);
+  }
+  std::size_t portSep = std::string::npos;
+  if (!authority.empty() && authority.front() == '[') {
+    const auto close = authority.find(']');
+    if (close == std::string::npos) return std::nullopt;
+    result.host = authority.substr(0, close + 1);
+    if (close + 1 < authority.size() && authority[close + 1] == ':') {
+      portSep = close + 1;
+    }
+  } else {
+    portSep = authority.rfind(':');
+    result.host = authority.substr(0, portSep);
+  }
+  if (portSep != std::string::npos) {
+    try {
+      result.port = std::stol(authority.substr(portSep + 1));
+    } catch (const std::exception&) {
+      return std::nullopt;
+    }
+  }
+  if (result.host.empty()) return std::nullopt;
+  return result;
+}
+
+std::future<std::optional<ResolvedAddress>> prefetchAddress(
+    const std::string& url) {
+  return std::async(std::launch::async,
+                    [url]() -> std::optional<ResolvedAddress> {
+#ifdef _WIN32
+    // getaddrinfo needs WSAStartup, which curl_global_init performs; let
+    // curl resolve on its own there.
+    (void)url;
+    return std::nullopt;
+#else
+    auto target = parseUrlHost(url);
+    if (!target || target->host.front() == '[') return std::nullopt;
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_ADDRCONFIG;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(target->host.c_str(), nullptr, &hints, &found) != 0) {
+      return std::nullopt;
+    }
+    for (const addrinfo* entry = found; entry != nullptr;
+         entry = entry->ai_next) {
+      if (entry->ai_family != AF_INET && entry->ai_family != AF_INET6) {
+        continue;
+      }
+      char text[INET6_ADDRSTRLEN] = {};
+      const void* raw =
+          entry->ai_family == AF_INET6
+              ? static_cast<const void*>(
+                    &reinterpret_cast<sockaddr_in6*>(entry->ai_addr)
+                         ->sin6_addr)
+              : static_cast<const void*>(
+                    &reinterpret_cast<sockaddr_in*>(entry->ai_addr)->sin_addr);
+      if (inet_ntop(entry->ai_family, raw, text, sizeof(text)) == nullptr) {
+        continue;
+      }
+      if (std::find(target->addresses.begin(), target->addresses.end(),
+                    text) == target->addresses.end()) {
+        target->addresses.emplace_back(text);
+      }
+    }
+    freeaddrinfo(found);
+    if (target->addresses.empty()) return std::nullopt;
+    return target;
+#endif
+  });
+}
@@ -0,0 +1,230 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/latencyHistogram.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr std::uint64_t MAX_VALUE =
+    (std::uint64_t{1} << LatencyHistogram::MAX_BITS) - 1;
+constexpr std::string_view DUMP_HEADER =
+    "# bitcoinexrc latency histograms v1";
+
+// "850ns", "12.4us", "3.21ms", "1.50s".
+std::string formatDuration(std::chrono::nanoseconds value) {
+  const double ns = static_cast<double>(value.count());
+  if (ns < 1e3) return fmt::format("{:.0f}ns", ns);
+  if (ns < 1e6) return fmt::format("{:.1f}us", ns / 1e3);
+  if (ns < 1e9) return fmt::format("{:.2f}ms", ns / 1e6);
+  return fmt::format("{:.2f}s", ns / 1e9);
+}
+
+std::uint64_t parseNumber(std::string_view& fields) {
+  while (!fields.empty() && fields.front() == ' ') fields.remove_prefix(1);
+  std::uint64_t value = 0;
+  const auto [end, error] =
+      std::from_chars(fields.data(), fields.data() + fields.size(), value);
+  if (error != std::errc() || end == fields.data()) {
+    throw std::runtime_error("Malformed histogram line");
+  }
+  fields.remove_prefix(static_cast<std::size_t>(end - fields.data()));
+  return value;
+}
+
+using Member = LatencyHistogram LatencyReport::*;
+constexpr std::pair<const char*, Member> REPORT_FIELDS[] = {
+    {"tick", &LatencyReport::tick},     {"fetch", &LatencyReport::fetch},
+    {"decode", &LatencyReport::decode}, {"output", &LatencyReport::output},
+    {"jitter", &LatencyReport::jitter}, {"age", &LatencyReport::age},
+};
+}  // namespace
+
+std::size_t LatencyHistogram::bucketOf(std::uint64_t value) {
+  value = std::min(value, MAX_VALUE);
+  if (value < SUB_COUNT) return static_cast<std::size_t>(value);
+  // Keep the top SUB_BITS bits: `sub` lies in [HALF_COUNT, SUB_COUNT).
+  const unsigned shift =
+      static_cast<unsigned>(std::bit_width(value)) - SUB_BITS;
+  const std::uint64_t sub = value >> shift;
+  return SUB_COUNT + (shift - 1) * HALF_COUNT +
+         static_cast<std::size_t>(sub - HALF_COUNT);
+}
+
+std::uint64_t LatencyHistogram::bucketTop(std::size_t bucket) {
+  if (bucket < SUB_COUNT) return bucket;
+  const std::size_t shift = (bucket - SUB_COUNT) / HALF_COUNT + 1;
+  const std::uint64_t sub = (bucket - SUB_COUNT) % HALF_COUNT + HALF_COUNT;
+  return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::noteExtremes(std::uint64_t low, std::uint64_t high) {
+  std::uint64_t seen = this->lowest.load(std::memory_order_relaxed);
+  while (low < seen && !this->lowest.compare_exchange_weak(
+                           seen, low, std::memory_order_relaxed)) {
+  }
+  seen = this->highest.load(std::memory_order_relaxed);
+  while (high > seen && !this->highest.compare_exchange_weak(
+                            seen, high, std::memory_order_relaxed)) {
+  }
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds value) {
+  const std::uint64_t ns =
+      std::min<std::uint64_t>(static_cast<std::uint64_t>(
+                                  std::max<std::int64_t>(value.count(), 0)),
+                              MAX_VALUE);
+  this->counts[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+  this->total.fetch_add(1, std::memory_order_relaxed);
+  this->sum.fetch_add(ns, std::memory_order_relaxed);
+  this->noteExtremes(ns, ns);
+}
+
+void LatencyHistogram::recordCount(std::size_t bucket, std::uint64_t count) {
+  if (bucket >= BUCKETS) throw std::out_of_range("Histogram bucket");
+  this->counts[bucket].fetch_add(count, std::memory_order_relaxed);
+  this->total.fetch_add(count, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other) {
+  if (other.count() == 0) return;
+  for (std::size_t i = 0; i < BUCKETS; ++i) {
+    const std::uint64_t n = other.counts[i].load(std::memory_order_relaxed);
+    if (n) this->counts[i].fetch_add(n, std::memory_order_relaxed);
+  }
+  this->total.fetch_add(other.total.load(), std::memory_order_relaxed);
+  this->sum.fetch_add(other.sum.load(), std::memory_order_relaxed);
+  this->noteExtremes(other.lowest.load(), other.highest.load());
+}
+
+std::chrono::nanoseconds LatencyHistogram::min() const {
+  const std::uint64_t low = this->lowest.load();
+  return std::chrono::nanoseconds(low == UINT64_MAX ? 0 : low);
+}
+
+std::chrono::nanoseconds LatencyHistogram::max() const {
+  return std::chrono::nanoseconds(this->highest.load());
+}
+
+std::chrono::nanoseconds LatencyHistogram::mean() const {
+  const std::uint64_t n = this->count();
+  return std::chrono::nanoseconds(n == 0 ? 0 : this->sum.load() / n);
+}
+
+std::chrono::nanoseconds LatencyHistogram::valueAt(double q) const {
+  const std::uint64_t n = this->count();
+  if (n == 0) return std::chrono::nanoseconds(0);
+  q = std::clamp(q, 0.0, 1.0);
+  // Rank of the sample at q, 1-based, rounded up as HdrHistogram does.
+  const auto rank = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(q * static_cast<double>(n) + 0.999999));
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < BUCKETS; ++i) {
+    seen += this->counts[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::min(std::chrono::nanoseconds(bucketTop(i)), this->max());
+    }
+  }
+  return this->max();
+}
+
+void LatencyHistogram::print(std::FILE* out, std::string_view name) const {
+  fmt::print(out,
+             "  {:<8}{:>9} {:>10} {:>10} {:>10} {:>10} {:>10}\n", name,
+             this->count(), formatDuration(this->valueAt(0.5)),
+             formatDuration(this->valueAt(0.9)),
+             formatDuration(this->valueAt(0.99)),
+             formatDuration(this->valueAt(0.999)),
+             formatDuration(this->max()));
+}
+
+std::string LatencyHistogram::serialize(std::string_view name) const {
+  std::string line = fmt::format("{} {} {} {} {} {} {}", name, SUB_BITS,
+                                 MAX_BITS, this->count(), this->min().count(),
+                                 this->max().count(), this->sum.load());
+  for (std::size_t i = 0; i < BUCKETS; ++i) {
+    const std::uint64_t n = this->counts[i].load(std::memory_order_relaxed);
+    if (n) line += fmt::format(" {}:{}", i, n);
+  }
+  return line;
+}
+
+void LatencyHistogram::mergeSerialized(std::string_view fields) {
+  if (parseNumber(fields) != SUB_BITS || parseNumber(fields) != MAX_BITS) {
+    throw std::runtime_error("Histogram layout differs from this build");
+  }
+  const std::uint64_t count = parseNumber(fields);
+  const std::uint64_t low = parseNumber(fields);
+  const std::uint64_t high = parseNumber(fields);
+  const std::uint64_t total = parseNumber(fields);
+  std::uint64_t seen = 0;
+  while (!fields.empty()) {
+    const std::uint64_t bucket = parseNumber(fields);
+    if (fields.empty() || fields.front() != ':') {
+      throw std::runtime_error("Malformed histogram bucket");
+    }
+    fields.remove_prefix(1);
+    const std::uint64_t n = parseNumber(fields);
+    this->recordCount(static_cast<std::size_t>(bucket), n);
+    seen += n;
+    while (!fields.empty() && fields.front() == ' ') fields.remove_prefix(1);
+  }
+  if (seen != count) throw std::runtime_error("Histogram count mismatch");
+  if (count) {
+    this->sum.fetch_add(total, std::memory_order_relaxed);
+    this->noteExtremes(low, high);
+  }
+}
+
+void LatencyReport::print(std::FILE* out) const {
+  bool any = false;
+  for (const auto& [name, member] : REPORT_FIELDS) {
+    if ((this->*member).count() == 0) continue;
+    if (!any) {
+      fmt::print(out, "Latency ({} ticks):\n  {:<8}{:>9} {:>10} {:>10} "
+                      "{:>10} {:>10} {:>10}\n",
+                 this->tick.count(), "", "count", "p50", "p90", "p99",
+                 "p99.9", "max");
+      any = true;
+    }
+    (this->*member).print(out, name);
+  }
+}
+
+void LatencyReport::save(const std::string& path) const {
+  std::ofstream file(path, std::ios::trunc);
+  if (!file) throw std::runtime_error("Cannot write histograms to " + path);
+  file << DUMP_HEADER << '\n';
+  for (const auto& [name, member] : REPORT_FIELDS) {
+    file << (this->*member).serialize(name) << '\n';
+  }
+  if (!file) throw std::runtime_error("Failed writing histograms to " + path);
+}
+
+void LatencyReport::merge(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) throw std::runtime_error("Cannot open histograms " + path);
+  std::string line;
+  if (!std::getline(file, line) || line != DUMP_HEADER) {
+    throw std::runtime_error(path + " is not a histogram dump");
+  }
+  while (std::getline(file, line)) {
+    const std::size_t space = line.find(' ');
+    const std::string_view name = std::string_view(line).substr(0, space);
+    // Names this build does not know (added later) are skipped.
+    for (const auto& [field, member] : REPORT_FIELDS) {
+      if (name != field) continue;
+      try {
+        (this->*member).mergeSerialized(
+            std::string_view(line).substr(std::min(space, line.size())));
+      } catch (const std::exception& e) {
+        throw std::runtime_error(path + ": " + e.what());
+      }
+    }
+  }
+}
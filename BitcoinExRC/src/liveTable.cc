@@ -0,0 +1,115 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/liveTable.h"
+
+#include <fmt/color.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+#include "../include/trace.h"
+
+LiveTable::LiveTable(TaskPool& pool, AlertEngine& alerts, Options options)
+    : pool(pool), alerts(alerts), options(std::move(options)) {
+  this->events.reserve(64);
+}
+
+TickArena& LiveTable::beginTick() {
+  this->arena.reset();
+  return this->arena;
+}
+
+void LiveTable::show(const Snapshot& snapshot, int update, bool clear) {
+  TaskGroup consumers(this->pool);
+  if (this->options.showCross) {
+    consumers.run([&] { this->cross.update(snapshot); });
+  }
+  if (this->alerts.size() > 0) {
+    consumers.run([&] {
+      this->events.clear();
+      this->alerts.evaluate(snapshot, this->events);
+    });
+  }
+  if (this->options.cache != nullptr) {
+    consumers.run([&] { this->persist(snapshot); });
+  }
+  {
+    TRACE_SPAN("render");
+    FrameBuffer frame(this->arena.allocator());
+#ifdef _WIN32
+    if (clear) std::system("cls");
+#else
+    // ANSI home + clear instead of forking clear(1) every frame.
+    if (clear) frame.append(std::string_view("\x1b[H\x1b[2J"));
+#endif
+    renderTable(frame, snapshot, update, this->options.interval, false,
+                this->options.asset);
+    writeFrame(frame, this->options.out);
+  }
+  consumers.wait();
+
+  FrameBuffer rest(this->arena.allocator());
+  if (this->options.showCross) this->renderCross(rest);
+  if (this->alerts.size() > 0) this->renderAlerts(rest);
+  if (rest.size() > 0) writeFrame(rest, this->options.out);
+}
+
+// A cache that cannot be written is reported once and otherwise ignored.
+void LiveTable::persist(const Snapshot& snapshot) {
+  try {
+    this->options.cache->save(snapshot);
+  } catch (const std::exception& e) {
+    if (!this->cacheFailed) fmt::print(stderr, "{}\n", e.what());
+    this->cacheFailed = true;
+  }
+}
+
+// The implied fiat-to-fiat "last" matrix: row = base, column = quote.
+void LiveTable::renderCross(FrameBuffer& out) {
+  using fmt::color;
+  using fmt::fg;
+
+  const std::vector<std::string>& names = this->cross.symbolNames();
+  const std::vector<std::string>& selection = this->options.crossSymbols;
+  this->columns.clear();
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    if (selection.empty() ||
+        std::find(selection.begin(), selection.end(), names[i]) !=
+            selection.end()) {
+      this->columns.push_back(i);
+    }
+  }
+
+  auto it = std::back_inserter(out);
+  fmt::format_to(it, fg(color::yellow), "\nCross rates (1 row = x column)\n\n");
+  fmt::format_to(it, fg(color::cyan), "{:<8}", "Base");
+  for (std::size_t quote : this->columns) {
+    fmt::format_to(it, fg(color::cyan), "│ {:>14} ", names[quote]);
+  }
+  fmt::format_to(it, "\n");
+  fmt::format_to(it, fg(color::light_blue), "{:-<{}}\n", "",
+                 8 + this->columns.size() * 17);
+  for (std::size_t base : this->columns) {
+    fmt::format_to(it, fg(color::green), "{:<8}", names[base]);
+    for (std::size_t quote : this->columns) {
+      fmt::format_to(it, "│ ");
+      fmt::format_to(it, fg(color::white), "{:>14.6g} ",
+                     this->cross.rate(CrossRateEngine::Field::Last, base,
+                                      quote));
+    }
+    fmt::format_to(it, "\n");
+  }
+}
+
+void LiveTable::renderAlerts(FrameBuffer& out) const {
+  auto it = std::back_inserter(out);
+  for (const AlertEvent& event : this->events) {
+    fmt::memory_buffer text;  // inline; a rule's text fits
+    this->alerts.rule(event.rule).describeTo(fmt::appender(text));
+    fmt::format_to(it, fg(fmt::color::yellow), "🔔 {}\n",
+                   std::string_view(text.data(), text.size()));
+  }
+}
@@ -4,86 +4,397 @@
 #include <fmt/color.h>
 #include <fmt/core.h>
 
+#include <algorithm>
 #include <atomic>
+#include <charconv>
 #include <chrono>
 #include <csignal>
+#include <cstdint>
+#include <cstdio>
 #include <ctime>
+#include <fstream>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
 #include <thread>
+#include <vector>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "../include/alerts.h"
+#include "../include/bench.h"
 #include "../include/bitcoin.h"
+#include "../include/connectionCache.h"
+#include "../include/deltaEncoder.h"
+#include "../include/dnsPrefetch.h"
+#include "../include/latencyHistogram.h"
+#include "../include/liveTable.h"
+#include "../include/outputSink.h"
+#include "../include/pipeline.h"
+#include "../include/providerSet.h"
+#include "../include/render.h"
+#include "../include/shutdown.h"
+#include "../include/snapshot.h"
+#include "../include/snapshotCache.h"
+#include "../include/taskPool.h"
+#include "../include/tickArena.h"
+#include "../include/tickScheduler.h"
+#include "../include/ticker.h"
+#include "../include/tickerDecoder.h"
+#include "../include/tickerGenerator.h"
+#include "../include/tickerStream.h"
+#include "../include/trace.h"
 
 using namespace std::chrono_literals;
 namespace bk = barkeep;
-using json = nlohmann::json;
-int refreshInterval = 3;  // seconds
+std::chrono::milliseconds refreshInterval = 3s;
 // Global flag for graceful shutdown
 std::atomic<bool> running{true};
+// False while streaming machine-readable output to stdout.
+bool interactive = true;
+// Taken during static initialization, as close to exec() as we can get.
+const auto processStart = std::chrono::steady_clock::now();
+bool reportTtfp = false;
+// --align: phase ticks to wall-clock multiples of the interval.
+bool alignTicks = false;
+// Tick, stage and scheduling latencies of this run, printed on exit.
+LatencyReport latency;
+// --histograms: where to save them for merging across instances.
+std::string histogramPath;
+// --asset: what the table header says is being priced.
+AssetInfo tickerAsset = Btc::INFO;
+
+// Fetch and decode come from the providers; output covers everything after
+// decode up to `done` (frame written or records handed to the sink). Age
+// is how old the snapshot's prices were by then, where that is known.
+void recordTickLatency(const ProviderSet& providers, const Snapshot& snapshot,
+                       std::chrono::steady_clock::time_point started,
+                       std::chrono::steady_clock::time_point decoded,
+                       std::chrono::steady_clock::time_point done) {
+  const TickerClient::StageTimes stages = providers.lastStageTimes();
+  latency.fetch.record(stages.fetch);
+  latency.decode.record(stages.decode);
+  latency.output.record(done - decoded);
+  latency.tick.record(done - started);
+  if (snapshot.freshness.known()) {
+    latency.age.record(
+        snapshot.freshness.ageAt(std::chrono::system_clock::now()));
+  }
+}
+
+// On exit of a polling run: percentiles to stderr (after "Goodbye!") and
+// the mergeable dump for --histograms.
+int finishLatencyReport(int status, bool print) {
+  if (print) latency.print(stderr);
+  if (histogramPath.empty()) return status;
+  try {
+    latency.save(histogramPath);
+  } catch (const std::exception& e) {
+    fmt::print(stderr, "{}\n", e.what());
+    return status == 0 ? 1 : status;
+  }
+  return status;
+}
+
+// Writes the --trace timeline when main() returns, whichever way it does.
+struct TraceWriter {
+  std::string path;
+  ~TraceWriter() {
+    if (this->path.empty()) return;
+    try {
+      const std::size_t spans = Tracer::write(this->path);
+      fmt::print(stderr, "Wrote {} trace spans to {}\n", spans, this->path);
+    } catch (const std::exception& e) {
+      fmt::print(stderr, "{}\n", e.what());
+    }
+  }
+};
+
+bool stdoutIsTerminal() {
+#ifdef _WIN32
+  return _isatty(_fileno(stdout)) != 0;
+#else
+  return isatty(fileno(stdout)) != 0;
+#endif
+}
+
+// --ttfp: prints process start -> first decoded price, once, to stderr.
+void reportTimeToFirstPrice(const TickerClient& ticker) {
+  static bool reported = false;
+  if (!reportTtfp || reported) return;
+  reported = true;
+  const double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - processStart)
+                        .count();
+  const TransferTimings t = ticker.lastTimings();
+  fmt::print(stderr,
+             "time-to-first-price: {:.1f} ms (dns {:.1f}, connect {:.1f}, "
+             "tls {:.1f}, first byte {:.1f}, transfer {:.1f} ms)\n",
+             ms, t.dns, t.connect, t.tls, t.firstByte, t.total);
+}
+
+// Persists the last good snapshot for the next start's warm frame. A cache
+// that cannot be written is reported once and otherwise ignored.
+void persistSnapshot(const SnapshotCache* cache, const Snapshot& snapshot) {
+  static bool warned = false;
+  if (cache == nullptr) return;
+  try {
+    cache->save(snapshot);
+  } catch (const std::exception& e) {
+    if (!warned) fmt::print(stderr, "{}\n", e.what());
+    warned = true;
+  }
+}
 
 void signalHandler(int /* signal */) {
   running = false;
+  notifyShutdownWakeup();
+  if (!interactive) return;
   fmt::print("\n\n{}\n",
              fmt::styled("Goodbye! 👋", fmt::fg(fmt::color::yellow)));
 }
 
-void clearScreen() {
-#ifdef _WIN32
-  system("cls");
-#else
-  system("clear");
-#endif
+// Draws the cached snapshot, clearly marked stale, while the first fetch
+// is still in flight.
+void printStaleTable(const Snapshot& data, TickArena& arena) {
+  TRACE_SPAN("render");
+  FrameBuffer frame(arena.allocator());
+  renderTable(frame, data, 0, refreshInterval, true, tickerAsset);
+  writeFrame(frame);
+  if (reportTtfp) {
+    fmt::print(stderr, "first frame (cached): {:.1f} ms\n",
+               std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - processStart)
+                   .count());
+  }
 }
 
-std::string getCurrentTimeString() {
-  auto now = std::chrono::system_clock::now();
-  auto time_t = std::chrono::system_clock::to_time_t(now);
+// --max-body: "64M", "512K", "1G" or plain bytes; 0 means no limit.
+std::size_t parseByteSize(std::string_view text) {
+  const std::string original(text);
+  std::size_t shift = 0;
+  if (!text.empty()) {
+    switch (text.back()) {
+      case 'K':
+      case 'k':
+        shift = 10;
+        break;
+      case 'M':
+      case 'm':
+        shift = 20;
+        break;
+      case 'G':
+      case 'g':
+        shift = 30;
+        break;
+      default:
+        break;
+    }
+  }
+  if (shift != 0) text.remove_suffix(1);
+  std::size_t value = 0;
+  const auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (text.empty() || ec != std::errc{} || end != text.data() + text.size() ||
+      value > (SIZE_MAX >> shift)) {
+    throw std::invalid_argument("Invalid size '" + original +
+                                "' (expected e.g. 512K, 64M or bytes)");
+  }
+  return value << shift;
+}
 
-#ifdef _WIN32
-  // Use localtime_s on Windows
-  std::tm tm_buf;
-  localtime_s(&tm_buf, &time_t);
-  return fmt::format("{:02d}:{:02d}:{:02d}", tm_buf.tm_hour, tm_buf.tm_min,
-                     tm_buf.tm_sec);
-#else
-  // Use localtime on Unix-like systems
-  std::tm* tm_ptr = std::localtime(&time_t);
-  return fmt::format("{:02d}:{:02d}:{:02d}", tm_ptr->tm_hour, tm_ptr->tm_min,
-                     tm_ptr->tm_sec);
-#endif
+std::vector<std::string> splitSymbols(std::string_view list) {
+  std::vector<std::string> symbols;
+  while (!list.empty()) {
+    auto comma = list.find(',');
+    auto item = list.substr(0, comma);
+    if (!item.empty()) symbols.emplace_back(item);
+    if (comma == std::string_view::npos) break;
+    list.remove_prefix(comma + 1);
+  }
+  return symbols;
 }
 
-void printColoredTable(const nlohmann::json& data, int updateCount = 0) {
-  using fmt::color;
-  using fmt::fg;
+// Alerts in the record modes, where stdout belongs to the sink: one line
+// per fired rule on stderr. `events` is the caller's, kept across ticks.
+void reportAlerts(AlertEngine& alerts, const Snapshot& snapshot,
+                  std::vector<AlertEvent>& events) {
+  if (alerts.size() == 0) return;
+  events.clear();
+  alerts.evaluate(snapshot, events);
+  for (const AlertEvent& event : events) {
+    fmt::memory_buffer text;
+    alerts.rule(event.rule).describeTo(fmt::appender(text));
+    fmt::print(stderr, "Alert: {}\n",
+               std::string_view(text.data(), text.size()));
+  }
+}
+
+// Rules fire on a crossing between two snapshots, and a one-shot run has
+// only one of its own. The previous run's, from the warm-start cache,
+// stands in for the other, so a run from cron reports what crossed since
+// the last one.
+void primeAlerts(AlertEngine& alerts, const SnapshotCache& cache,
+                 const SymbolFilter& filter) {
+  Snapshot previous;
+  std::vector<AlertEvent> ignored;
+  if (cache.load(previous, filter) && !previous.empty()) {
+    alerts.evaluate(previous, ignored);
+  }
+}
+
+void printProviderErrors(const ProviderSet& providers) {
+  for (const std::string& error : providers.errors()) {
+    fmt::print(stderr, "Provider failed, using the others: {}\n", error);
+  }
+}
+
+// --format / --daemon mode: fetch -> decode -> publish, no ANSI, no
+// animation. Ticks sit on absolute deadlines and the loop blocks once per
+// tick until the next one, so an idle daemon does not wake up at all.
+// Providers fetch in parallel and the consumers of a tick (sink, cache,
+// alerts) run as pool tasks.
+int runStreaming(ProviderSet& providers, const TickerDecoder& decoder,
+                 OutputSink& sink, bool realTime, const SnapshotCache* cache,
+                 AlertEngine& alerts, TaskPool& pool) {
+  TickArena arena;
+  std::vector<AlertEvent> events;
+  TickScheduler scheduler(refreshInterval, alignTicks);
+  do {
+    try {
+      TRACE_SPAN("tick");
+      arena.reset();
+      const auto started = std::chrono::steady_clock::now();
+      Snapshot snapshot(arena.allocator());
+      providers.fetchSnapshot(decoder, snapshot);
+      const auto decoded = std::chrono::steady_clock::now();
+      printProviderErrors(providers);
+      TaskGroup consumers(pool);
+      consumers.run([&] {
+        TRACE_SPAN("output");
+        sink.write(snapshot);
+        if (reportTtfp) {
+          sink.flush();
+          reportTimeToFirstPrice(providers.primary());
+        }
+      });
+      consumers.run([&] { persistSnapshot(cache, snapshot); });
+      if (alerts.size() > 0) {
+        consumers.run([&] { reportAlerts(alerts, snapshot, events); });
+      }
+      consumers.wait();
+      recordTickLatency(providers, snapshot, started, decoded,
+                        std::chrono::steady_clock::now());
+    } catch (const std::exception& e) {
+      fmt::print(stderr, "Error fetching data: {}\n", e.what());
+      if (!realTime) return 1;
+    }
+    if (!realTime) break;
+    // Failed fetches included: candles close on the clock, not on the
+    // next good tick.
+    try {
+      sink.advance(std::chrono::system_clock::now());
+    } catch (const std::exception& e) {
+      fmt::print(stderr, "Error writing candles: {}\n", e.what());
+    }
+  } while (running && scheduler.waitNext());
+  sink.flush();
+  latency.jitter.add(scheduler.jitter());
+  return 0;
+}
 
-  // Print header with update info
-  fmt::print(fg(color::yellow), "*");
-  fmt::print(fg(color::orange), "LIVE Bitcoin Rates ");
-  fmt::print(fg(color::gray), "(Update #{} at {})\n", updateCount,
-             getCurrentTimeString());
-  fmt::print(fg(color::yellow), "1 BTC =\n\n");
+void printStreamStats(const TickerStream& stream) {
+  const TickerStream::Stats& s = stream.stats();
+  fmt::print(stderr,
+             "Stream: {} messages ({} snapshots), {} reconnects, {} seq gaps\n",
+             s.messages, s.snapshots, s.reconnects, s.gaps);
+  if (s.latencySamples > 0) {
+    fmt::print(stderr,
+               "Stream latency: min {:.0f} us, mean {:.0f} us, max {:.0f} us\n",
+               s.latencyMinUs,
+               s.latencySumUs / static_cast<double>(s.latencySamples),
+               s.latencyMaxUs);
+  }
+}
 
-  // Table header
-  fmt::print(fg(color::cyan), "{:<8}│ {:>12} │ {:>12} │ {:>12} │ {:>12}\n",
-             "Symbol", "15m", "Last", "Buy", "Sell");
-  fmt::print(fg(color::light_blue), "{:-<65}\n", "");
+// Waits for the next batch of pushed updates, reporting (not propagating)
+// connection errors; the stream reconnects on its own. Returns true if
+// `live` changed.
+bool nextStreamBatch(TickerStream& stream, Snapshot& live) {
+  try {
+    return stream.waitForUpdates(
+               live, std::chrono::steady_clock::now() + 1s) > 0;
+  } catch (const std::exception& e) {
+    fmt::print(stderr, "{}; reconnecting\n", e.what());
+    return false;
+  }
+}
 
-  // Table data
-  for (const auto& [symbol, info] : data.items()) {
-    fmt::print(fg(color::green), "{:<8}", symbol);
-    fmt::print("│ ");
-    fmt::print(fg(color::white),
-               "{:>12.2f} │ {:>12.2f} │ {:>12.2f} │ {:>12.2f}\n",
-               info["15m"].get<double>(), info["last"].get<double>(),
-               info["buy"].get<double>(), info["sell"].get<double>());
+// --stream with --format / --daemon: publishes the snapshot every time the
+// subscription delivers updates instead of on a timer.
+int runSubscription(TickerStream& stream, OutputSink& sink, bool realTime,
+                    AlertEngine& alerts) {
+  Snapshot live;
+  std::vector<AlertEvent> events;
+  while (running) {
+    if (!nextStreamBatch(stream, live)) {
+      sink.advance(std::chrono::system_clock::now());
+      continue;
+    }
+    sink.write(live);
+    reportAlerts(alerts, live, events);
+    if (!realTime) break;
   }
+  sink.flush();
+  printStreamStats(stream);
+  return 0;
+}
 
-  // Footer with instructions
-  fmt::print("\n");
-  fmt::print(fg(color::gray),
-             "Press Ctrl+C to exit • Auto-refresh every {}s\n",refreshInterval);
-  fmt::print(fg(color::dark_gray), "{:-<65}\n", "");
+// --replay: pushes recorded payloads (one ticker JSON per line) through the
+// decoder and sink as fast as possible.
+int runReplay(const std::string& path, const TickerKind& kind,
+              const TickerDecoder& decoder, OutputSink& sink,
+              AlertEngine& alerts) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    fmt::print(stderr, "Cannot open replay file: {}\n", path);
+    return 1;
+  }
+  TickArena arena;
+  std::vector<AlertEvent> events;
+  std::string line;
+  std::size_t ticks = 0;
+  const auto start = std::chrono::steady_clock::now();
+  while (running && std::getline(in, line)) {
+    if (line.empty()) continue;
+    try {
+      arena.reset();
+      Snapshot snapshot(arena.allocator());
+      kind.decode(decoder, TickerClient::validateAndCleanJson(line), snapshot);
+      sink.write(snapshot);
+      reportAlerts(alerts, snapshot, events);
+      ++ticks;
+    } catch (const std::exception& e) {
+      fmt::print(stderr, "Skipping bad payload on tick {}: {}\n", ticks + 1,
+                 e.what());
+    }
+  }
+  sink.flush();
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  fmt::print(stderr,
+             "Replayed {} ticks, {} records in {:.3f}s ({:.0f} rec/s)\n", ticks,
+             sink.records(), seconds,
+             static_cast<double>(sink.records()) / seconds);
+  return 0;
 }
 
 void printWelcomeMessage() {
@@ -92,8 +403,8 @@ void printWelcomeMessage() {
 
   fmt::print(fg(color::yellow), "🚀 ");
   fmt::print(fg(color::white), "Bitcoin Real-Time Tracker Started\n");
-  fmt::print(fg(color::gray), "Fetching live data every {} seconds...\n\n",
-             refreshInterval);
+  fmt::print(fg(color::gray), "Fetching live data every {}...\n\n",
+             formatInterval(refreshInterval));
 }
 
 int main(int argc, char* argv[]) {
@@ -101,8 +412,35 @@ int main(int argc, char* argv[]) {
   std::signal(SIGINT, signalHandler);
   std::signal(SIGTERM, signalHandler);
 
+  initShutdownWakeup();
+
   // Parse command line arguments
   bool realTimeMode = true;
+  bool daemonMode = false;
+  bool showCross = false;
+  std::vector<std::string> crossSymbols;
+  std::vector<std::string> symbols;
+  AlertEngine alerts;
+  std::optional<OutputFormat> outputFormat;
+  std::string outputPath;
+  std::string replayPath;
+  std::size_t flushEvery = 1;
+  std::size_t deltaKeyframeEvery = 0;
+  std::string candlesPath;
+  std::vector<std::string> urls;
+  std::size_t workers = 0;
+  std::string streamUrl;
+  std::string cachePath;
+  std::string connectionCachePath;
+  bool useCache = true;
+  bool usePipeline = false;
+  PipelineOptions pipelineOptions;
+  std::string benchName;
+  std::vector<std::string> mergeHistograms;
+  std::string tracePath;
+  std::size_t generateSymbols = 0;
+  std::string assetName = "btc";
+  std::size_t maxBody = CurlHandler::DEFAULT_MAX_BODY;
 
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
@@ -111,86 +449,603 @@ int main(int argc, char* argv[]) {
     } else if (arg == "--interval" || arg == "-i") {
       if (i + 1 < argc) {
         try {
-          refreshInterval = std::stoi(argv[++i]);
-          if (refreshInterval < 5) refreshInterval = 5;  // Minimum 5 seconds
+          refreshInterval = TickScheduler::parseInterval(argv[++i]);
+        } catch (const std::exception& e) {
+          fmt::print(fg(fmt::color::red), "{}\n", e.what());
+          return 1;
+        }
+      }
+    } else if (arg == "--align") {
+      alignTicks = true;
+    } else if (arg == "--max-body") {
+      if (i + 1 < argc) {
+        try {
+          maxBody = parseByteSize(argv[++i]);
+        } catch (const std::exception& e) {
+          fmt::print(fg(fmt::color::red), "{}\n", e.what());
+          return 1;
+        }
+      }
+    } else if (arg == "--asset") {
+      if (i + 1 < argc) assetName = argv[++i];
+    } else if (arg == "--generate") {
+      if (i + 1 < argc) {
+        try {
+          generateSymbols = std::stoul(argv[++i]);
+        } catch (const std::exception&) {
+          fmt::print(fg(fmt::color::red), "Invalid --generate value\n");
+          return 1;
+        }
+      }
+    } else if (arg == "--trace") {
+      if (i + 1 < argc) tracePath = argv[++i];
+    } else if (arg == "--histograms") {
+      if (i + 1 < argc) histogramPath = argv[++i];
+    } else if (arg == "--merge-histograms") {
+      while (i + 1 < argc && argv[i + 1][0] != '-') {
+        mergeHistograms.emplace_back(argv[++i]);
+      }
+    } else if (arg == "--cross" || arg == "-x") {
+      showCross = true;
+      if (i + 1 < argc && argv[i + 1][0] != '-') {
+        std::string_view value = argv[++i];
+        if (value != "all") crossSymbols = splitSymbols(value);
+      }
+    } else if (arg == "--symbols" || arg == "-s") {
+      if (i + 1 < argc) symbols = splitSymbols(argv[++i]);
+    } else if (arg == "--alert" || arg == "-a") {
+      if (i + 1 < argc) {
+        try {
+          alerts.add(AlertRule::parse(argv[++i]));
+        } catch (const std::exception& e) {
+          fmt::print(fg(fmt::color::red), "{}\n", e.what());
+          return 1;
+        }
+      }
+    } else if (arg == "--alerts-file") {
+      if (i + 1 < argc) {
+        try {
+          alerts.loadFile(argv[++i]);
+        } catch (const std::exception& e) {
+          fmt::print(fg(fmt::color::red), "{}\n", e.what());
+          return 1;
+        }
+      }
+    } else if (arg == "--daemon" || arg == "-d") {
+      daemonMode = true;
+    } else if (arg == "--format" || arg == "-f") {
+      if (i + 1 < argc) {
+        try {
+          outputFormat = OutputSink::parseFormat(argv[++i]);
+        } catch (const std::exception& e) {
+          fmt::print(fg(fmt::color::red), "{}\n", e.what());
+          return 1;
+        }
+      }
+    } else if (arg == "--output" || arg == "-o") {
+      if (i + 1 < argc) outputPath = argv[++i];
+    } else if (arg == "--flush-every") {
+      if (i + 1 < argc) {
+        try {
+          flushEvery = std::stoul(argv[++i]);
         } catch (const std::exception&) {
-          fmt::print(fg(fmt::color::red), "Invalid interval value\n");
+          fmt::print(fg(fmt::color::red), "Invalid --flush-every value\n");
           return 1;
         }
       }
+    } else if (arg == "--delta") {
+      deltaKeyframeEvery = DeltaEncoder::DEFAULT_KEYFRAME_EVERY;
+      if (i + 1 < argc && argv[i + 1][0] != '-') {
+        try {
+          deltaKeyframeEvery = std::stoul(argv[++i]);
+        } catch (const std::exception&) {
+          deltaKeyframeEvery = 0;
+        }
+        if (deltaKeyframeEvery == 0) {
+          fmt::print(fg(fmt::color::red), "Invalid --delta value\n");
+          return 1;
+        }
+      }
+    } else if (arg == "--candles") {
+      if (i + 1 < argc) candlesPath = argv[++i];
+    } else if (arg == "--replay") {
+      if (i + 1 < argc) replayPath = argv[++i];
+    } else if (arg == "--url") {
+      if (i + 1 < argc) urls.emplace_back(argv[++i]);
+    } else if (arg == "--workers") {
+      if (i + 1 < argc) {
+        try {
+          workers = std::stoul(argv[++i]);
+        } catch (const std::exception&) {
+          fmt::print(fg(fmt::color::red), "Invalid --workers value\n");
+          return 1;
+        }
+      }
+    } else if (arg == "--stream") {
+      if (i + 1 < argc) streamUrl = argv[++i];
+    } else if (arg == "--pipeline") {
+      usePipeline = true;
+      if (i + 1 < argc && argv[i + 1][0] != '-') {
+        try {
+          pipelineOptions.depth = std::stoul(argv[++i]);
+        } catch (const std::exception&) {
+          fmt::print(fg(fmt::color::red), "Invalid --pipeline depth\n");
+          return 1;
+        }
+      }
+    } else if (arg == "--overflow") {
+      if (i + 1 < argc) {
+        try {
+          pipelineOptions.overflow = PipelineOptions::parseOverflow(argv[++i]);
+        } catch (const std::exception& e) {
+          fmt::print(fg(fmt::color::red), "{}\n", e.what());
+          return 1;
+        }
+      }
+    } else if (arg == "--cache") {
+      if (i + 1 < argc) cachePath = argv[++i];
+    } else if (arg == "--conn-cache") {
+      if (i + 1 < argc) connectionCachePath = argv[++i];
+    } else if (arg == "--no-cache") {
+      useCache = false;
+    } else if (arg == "--ttfp") {
+      reportTtfp = true;
+    } else if (arg == "--bench") {
+      if (i + 1 >= argc) {
+        fmt::print(fg(fmt::color::red), "--bench needs a benchmark name\n");
+        return 1;
+      }
+      benchName = argv[++i];
     } else if (arg == "--help" || arg == "-h") {
       fmt::print("Usage: {} [options]\n", argv[0]);
       fmt::print("Options:\n");
       fmt::print("  --once, -1              Fetch data once and exit\n");
       fmt::print(
-          "  --interval, -i <secs>   Refresh interval (default: 30, min: 5)\n");
+          "  --interval, -i <time>   Refresh interval: 500ms, 2s, 10 (seconds;\n"
+          "                          default 3, min 5 for the default URL)\n");
+      fmt::print(
+          "  --align                 Tick on wall-clock multiples of the "
+          "interval\n");
+      fmt::print(
+          "  --generate <n>          Print a synthetic ticker with n symbols "
+          "(for --replay)\n");
+      fmt::print(
+          "  --trace <path>          Write a Chrome trace-event timeline of "
+          "fetch,\n"
+          "                          parse, render and sleep spans on exit\n");
+      fmt::print(
+          "  --histograms <path>     Save latency histograms on exit "
+          "(mergeable)\n");
+      fmt::print(
+          "  --merge-histograms <paths...>\n"
+          "                          Combine saved histograms and print "
+          "percentiles\n");
+      fmt::print(
+          "  --cross, -x [SYMS|all]  Show implied cross rates (e.g. EUR,JPY)\n");
+      fmt::print(
+          "  --symbols, -s <SYMS>    Only fetch these symbols (e.g. USD,EUR)\n");
+      fmt::print(
+          "  --alert, -a <RULE>      Alert rule: USD>120000, USD<90000,\n"
+          "                          USD%2.5/15m (move), USD~150 (spread);\n"
+          "                          to stderr with --format or --daemon\n");
+      fmt::print("  --alerts-file <path>    Load alert rules, one per line\n");
+      fmt::print(
+          "  --daemon, -d            Headless: fetch and publish only "
+          "(default --format ndjson)\n");
+      fmt::print(
+          "  --format, -f <fmt>      Stream ndjson, csv or bin records instead "
+          "of the table\n");
+      fmt::print("  --output, -o <path>     Write --format output to a file\n");
+      fmt::print(
+          "  --flush-every <ticks>   Flush output every N ticks (0 = when "
+          "full, default 1)\n");
+      fmt::print(
+          "  --delta [ticks]         Only emit changed symbols and fields, "
+          "with a full\n"
+          "                          keyframe every N ticks (default 60)\n");
+      fmt::print(
+          "  --candles <path>        Also write closed 1m/5m/15m/1h/1d OHLC "
+          "candles in --format\n");
+      fmt::print(
+          "  --replay <path>         Replay recorded payloads (one per line) "
+          "through --format\n");
+      fmt::print(
+          "  --url <url>             Ticker endpoint; repeat to merge several "
+          "(default: {})\n",
+          BitCoin::DEFAULT_URL);
+      fmt::print(
+          "  --max-body <size>       Abort responses larger than this "
+          "(default 64M, 0 = no limit)\n");
+      fmt::print(
+          "  --asset <name>          What every --url quotes: {} (default "
+          "btc)\n",
+          TickerKind::names());
+      fmt::print(
+          "  --workers <n>           Task pool threads (default: one per "
+          "core)\n");
+      fmt::print(
+          "  --stream <ws-url>       Subscribe to pushed updates instead of "
+          "polling\n");
+      fmt::print(
+          "  --pipeline [depth]      Fetch, decode and output on separate "
+          "threads (default depth 4)\n");
+      fmt::print(
+          "  --overflow <policy>     Full pipeline queue: drop-oldest "
+          "(default) or block\n");
+      fmt::print(
+          "  --cache <path>          Warm-start snapshot cache (default: "
+          "{})\n",
+          SnapshotCache::defaultPath());
+      fmt::print(
+          "  --conn-cache <path>     --once: resolved address + TLS session "
+          "cache (default: {})\n",
+          ConnectionCache::defaultPath());
+      fmt::print(
+          "  --no-cache              Neither read nor write the snapshot "
+          "or connection cache\n");
+      fmt::print(
+          "  --ttfp                  Report time-to-first-price on stderr\n");
+      fmt::print("  --bench <name>          Run a built-in benchmark ({})\n",
+                 benchmarkNames());
       fmt::print("  --help, -h              Show this help\n");
       return 0;
     }
   }
 
+  if (!tracePath.empty()) {
+    if (!Tracer::available()) {
+      fmt::print(fg(fmt::color::red),
+                 "--trace needs a build configured with "
+                 "-DENABLE_TRACING=ON\n");
+      return 1;
+    }
+    Tracer::start();
+    Tracer::nameThread("main");
+  }
+  // Declared before the pool and pipeline so their threads are joined
+  // (and done recording) by the time it writes.
+  TraceWriter traceWriter{tracePath};
+
+  if (!mergeHistograms.empty()) {
+    try {
+      for (const std::string& path : mergeHistograms) latency.merge(path);
+    } catch (const std::exception& e) {
+      fmt::print(fg(fmt::color::red), "{}\n", e.what());
+      return 1;
+    }
+    latency.print(stdout);
+    return finishLatencyReport(0, false);
+  }
+  const TickerKind* kind = nullptr;
   try {
-    BitCoin bitcoin;
+    kind = &TickerKind::find(assetName);
+  } catch (const std::exception& e) {
+    fmt::print(fg(fmt::color::red), "{}\n", e.what());
+    return 1;
+  }
+  tickerAsset = kind->asset;
+  if (urls.empty() && kind->defaultUrl != nullptr) {
+    urls.emplace_back(kind->defaultUrl);
+  }
+  // Replays, streams and --generate never fetch from `url`.
+  if (urls.empty() && replayPath.empty() && streamUrl.empty() &&
+      generateSymbols == 0) {
+    fmt::print(fg(fmt::color::red),
+               "--asset {} has no public endpoint; pass --url\n", kind->name);
+    return 1;
+  }
+  // Sub-5s polling is for local or internal sources; keep the public
+  // endpoint at its old floor.
+  if (refreshInterval < 5s &&
+      std::find(urls.begin(), urls.end(), BitCoin::DEFAULT_URL) !=
+          urls.end()) {
+    refreshInterval = 5s;
+  }
+  const std::string url = urls.empty() ? std::string() : urls.front();
+  if (generateSymbols > 0) {
+    const std::string payload = syntheticTicker(generateSymbols);
+    std::fwrite(payload.data(), 1, payload.size(), stdout);
+    std::fputc('\n', stdout);
+    return 0;
+  }
+  if (!benchName.empty()) {
+    return runBenchmark(benchName,
+                        BenchOptions{argv[0], url, replayPath, workers});
+  }
+  if (usePipeline && urls.size() > 1) {
+    fmt::print(stderr, "--pipeline takes a single --url\n");
+    return 1;
+  }
+
+  // Outside the try: a failed --once run drops it in the handler below, in
+  // case the cached address is what failed.
+  std::optional<ConnectionCache> connections;
+  try {
+    const SymbolFilter filter(symbols);
+    const TickerDecoder decoder{filter};
+    std::optional<SnapshotCache> cache;
+    if (useCache) {
+      if (cachePath.empty()) {
+        cachePath = SnapshotCache::defaultPath(
+            std::string_view(kind->name) == "btc" ? "" : kind->name);
+      }
+      if (!cachePath.empty()) cache.emplace(cachePath);
+    }
+    const SnapshotCache* cacheFile = cache ? &*cache : nullptr;
+    TaskPool pool(workers);
+    // --once fast path: resolve DNS on a worker while libcurl and the TLS
+    // library initialize in the ticker's constructor, then hand curl the
+    // address so the transfer starts with the connect. The connection
+    // cache skips even that while the last run's address is fresh, and
+    // seeds curl with the last run's TLS sessions (where libcurl can
+    // import them) so the handshake resumes.
+    const bool oneShot = !realTimeMode && !daemonMode && replayPath.empty() &&
+                         streamUrl.empty();
+    if (oneShot && alerts.size() > 0) {
+      if (!cacheFile) {
+        fmt::print(stderr,
+                   "--alert in a one-shot run compares against the previous "
+                   "run's prices in the snapshot cache; drop --no-cache\n");
+        return 1;
+      }
+      primeAlerts(alerts, *cacheFile, filter);
+    }
+    std::future<std::optional<ResolvedAddress>> dns;
+    std::optional<ResolvedAddress> pinned;
+    if (oneShot) {
+      if (useCache) {
+        if (connectionCachePath.empty()) {
+          connectionCachePath = ConnectionCache::defaultPath();
+        }
+        if (!connectionCachePath.empty()) {
+          connections.emplace(connectionCachePath);
+          connections->load();
+        }
+      }
+      if (auto host = parseUrlHost(url); host && connections) {
+        pinned = connections->address(host->host, host->port);
+      }
+      if (!pinned) dns = prefetchAddress(url);
+    }
+    bool freshlyResolved = false;  // pinned came from DNS, not the cache
+    auto pinPrefetched = [&](TickerClient& ticker) {
+      if (dns.valid()) {
+        pinned = dns.get();
+        freshlyResolved = pinned.has_value();
+      }
+      if (pinned) ticker.pinAddress(*pinned);
+      if (connections) ticker.importTlsSessions(connections->sessions());
+    };
+    // After a successful --once fetch: what the next run can reuse. Only a
+    // fresh lookup is stored; storing a cached address again would restart
+    // its TTL, and an address would then never be re-resolved while the
+    // tool keeps running within it.
+    auto rememberConnection = [&](const TickerClient& ticker) {
+      if (!connections) return;
+      const std::vector<TlsSession> sessions = ticker.exportTlsSessions();
+      if (!freshlyResolved && sessions.empty()) return;
+      if (freshlyResolved) connections->remember(*pinned);
+      connections->keepSessions(sessions);
+      try {
+        connections->save();
+      } catch (const std::exception& e) {
+        fmt::print(stderr, "{}\n", e.what());
+      }
+    };
+    if (daemonMode && !replayPath.empty()) {
+      fmt::print(stderr, "--daemon and --replay cannot be combined\n");
+      return 1;
+    }
+    if (!streamUrl.empty() && !replayPath.empty()) {
+      fmt::print(stderr, "--stream and --replay cannot be combined\n");
+      return 1;
+    }
+    const bool streamsRecords =
+        daemonMode || outputFormat || !replayPath.empty();
+    if (!candlesPath.empty() && !streamsRecords) {
+      fmt::print(stderr, "--candles needs --format, --daemon or --replay\n");
+      return 1;
+    }
+    if (streamsRecords) {
+      interactive = false;
+      const OutputFormat format = outputFormat.value_or(OutputFormat::Ndjson);
+      auto sink = OutputSink::create(format, outputPath, flushEvery,
+                                     deltaKeyframeEvery);
+      if (!candlesPath.empty()) {
+        sink->setCandles(std::make_unique<CandleSink>(format, candlesPath));
+      }
+      if (!replayPath.empty()) {
+        return runReplay(replayPath, *kind, decoder, *sink, alerts);
+      }
+      if (!streamUrl.empty()) {
+        TickerStream stream(streamUrl, decoder);
+        return runSubscription(stream, *sink, daemonMode || realTimeMode,
+                               alerts);
+      }
+      ProviderSet providers(urls, pool, *kind);
+      providers.setMaxBody(maxBody);
+      pinPrefetched(providers.primary());
+      if (usePipeline) {
+        pipelineOptions.interval = refreshInterval;
+        pipelineOptions.alignToWallClock = alignTicks;
+        Pipeline pipeline(providers.primary(), decoder, pipelineOptions,
+                          latency);
+        std::vector<AlertEvent> events;
+        pipeline.run(
+            [&](const Snapshot& snapshot) {
+              sink->write(snapshot);
+              persistSnapshot(cacheFile, snapshot);
+              reportAlerts(alerts, snapshot, events);
+            },
+            daemonMode || realTimeMode);
+        sink->flush();
+        pipeline.printMetrics(stderr);
+        // As runStreaming: a one-shot run fails unless its tick got through.
+        const bool failed = pipeline.errors() > 0 || pipeline.written() == 0;
+        const int status = !(daemonMode || realTimeMode) && failed ? 1 : 0;
+        if (connections) {
+          if (status == 0) {
+            rememberConnection(providers.primary());
+          } else {
+            connections->discard();
+          }
+        }
+        return finishLatencyReport(status, daemonMode || realTimeMode);
+      }
+      const int status = runStreaming(providers, decoder, *sink,
+                                      daemonMode || realTimeMode, cacheFile,
+                                      alerts, pool);
+      if (connections) {
+        if (status == 0) {
+          rememberConnection(providers.primary());
+        } else {
+          connections->discard();
+        }
+      }
+      return finishLatencyReport(status, daemonMode || realTimeMode);
+    }
+
+    LiveTable::Options tableOptions;
+    tableOptions.interval = refreshInterval;
+    tableOptions.asset = tickerAsset;
+    tableOptions.showCross = showCross;
+    tableOptions.crossSymbols = crossSymbols;
+    tableOptions.cache = cacheFile;
     int updateCount = 0;
 
+    if (!streamUrl.empty()) {
+      // Pushed updates: redraw per batch, no polling, no countdown.
+      tableOptions.interval = std::chrono::milliseconds(0);
+      tableOptions.cache = nullptr;
+      LiveTable table(pool, alerts, std::move(tableOptions));
+      TickerStream stream(streamUrl, decoder);
+      Snapshot live;
+      while (running) {
+        if (!nextStreamBatch(stream, live)) continue;
+        table.beginTick();
+        table.show(live, ++updateCount, realTimeMode);
+        if (!realTimeMode) break;
+      }
+      printStreamStats(stream);
+      return 0;
+    }
+
+    // Warm start: the last good snapshot is on screen before curl is even
+    // initialized; the live fetch below replaces it.
+    LiveTable table(pool, alerts, std::move(tableOptions));
+    const bool animate = stdoutIsTerminal();
+    bool warmFrame = false;
+    if (cache && animate) {
+      TickArena& arena = table.beginTick();
+      Snapshot cached(arena.allocator());
+      if (cache->load(cached, filter) && !cached.empty()) {
+        printStaleTable(cached, arena);
+        warmFrame = true;
+      }
+    }
+
+    ProviderSet providers(urls, pool, *kind);
+    providers.setMaxBody(maxBody);
+    pinPrefetched(providers.primary());
+
     if (!realTimeMode) {
       // Single fetch mode (original behavior)
-      auto anim = bk::Animation({.message = "Fetching latest data"});
-      json bitCoinData = bitcoin.fetch();
+      auto anim = bk::Animation(
+          {.message = "Fetching latest data", .show = animate});
+      Snapshot bitCoinData(table.beginTick().allocator());
+      providers.fetchSnapshot(decoder, bitCoinData);
       anim->done();
-      printColoredTable(bitCoinData);
+      printProviderErrors(providers);
+      table.show(bitCoinData, 0, warmFrame);
+      reportTimeToFirstPrice(providers.primary());
+      rememberConnection(providers.primary());
       return 0;
     }
 
     // Real-time mode
     printWelcomeMessage();
+    if (usePipeline) {
+      // The output stage thread shows each snapshot; its cross rates,
+      // alerts and cache write go to the pool as in the loop below.
+      pipelineOptions.interval = refreshInterval;
+      pipelineOptions.alignToWallClock = alignTicks;
+      Pipeline pipeline(providers.primary(), decoder, pipelineOptions,
+                        latency);
+      pipeline.run(
+          [&](const Snapshot& snapshot) {
+            table.beginTick();
+            table.show(snapshot, ++updateCount);
+          },
+          true);
+      pipeline.printMetrics(stderr);
+      return finishLatencyReport(0, true);
+    }
+    const std::string updateMessage =
+        fmt::format("Updating... ({} interval)",
+                    formatInterval(refreshInterval));
+    TickScheduler scheduler(refreshInterval, alignTicks);
 
     while (running) {
       try {
-        // Show loading animation
-        auto anim =
-            bk::Animation({.message = fmt::format("Updating... ({}s interval)",
-                                                  refreshInterval)});
+        // Everything decoded and rendered this tick lives on the arena.
+        TickArena& arena = table.beginTick();
+        const auto started = std::chrono::steady_clock::now();
+
+        // A plain status line rather than an animation: barkeep starts a
+        // display thread for every animation, which would be the tick's
+        // only heap allocation.
+        if (animate) {
+          fmt::print(fg(fmt::color::gray), "\r{}", updateMessage);
+          std::fflush(stdout);
+        }
 
         // Fetch data
-        json bitCoinData = bitcoin.fetch();
-        anim->done();
+        Snapshot bitCoinData(arena.allocator());
+        providers.fetchSnapshot(decoder, bitCoinData);
+        const auto decoded = std::chrono::steady_clock::now();
 
         // Clear screen and display updated data
-        clearScreen();
-        printColoredTable(bitCoinData, ++updateCount);
-
-        // Wait for next update (with interruption check)
-        for (int i = 0; i < refreshInterval && running; ++i) {
-          std::this_thread::sleep_for(1s);
-
-          // Show countdown in the last 10 seconds
-          if (running && refreshInterval - i <= 10) {
-            fmt::print("\r{}", fmt::styled(fmt::format("Next update in {}s...",
-                                                       refreshInterval - i),
-                                           fmt::fg(fmt::color::gray)));
-            std::cout.flush();
+        table.show(bitCoinData, ++updateCount);
+        printProviderErrors(providers);
+        reportTimeToFirstPrice(providers.primary());
+        recordTickLatency(providers, bitCoinData, started, decoded,
+                          std::chrono::steady_clock::now());
+
+        // Wait for the next tick, with a countdown over its last 10 seconds
+        // on slow intervals. The countdown steps sit on the tick's own
+        // deadline, so they do not add drift.
+        const auto deadline = scheduler.next();
+        if (refreshInterval >= 2s) {
+          TRACE_SPAN("sleep");
+          auto left = std::chrono::ceil<std::chrono::seconds>(
+              deadline - std::chrono::steady_clock::now());
+          for (; left > 1s && running; --left) {
+            if (left <= 10s) {
+              fmt::print(fg(fmt::color::gray), "\rNext update in {}s...",
+                         left.count());
+              std::fflush(stdout);
+            }
+            if (!sleepUntilOrShutdown(deadline - (left - 1s))) break;
           }
         }
-
-        if (running) {
+        if (!running || !scheduler.wait()) break;
+        if (refreshInterval >= 2s) {
           fmt::print("\r{:<30}\r", "");  // Clear countdown
         }
 
       } catch (const std::exception& e) {
         fmt::print(fg(fmt::color::red), "Error fetching data: {}\n", e.what());
-        fmt::print(fg(fmt::color::gray), "Retrying in {}s...\n",
-                   refreshInterval);
-
-        // Wait before retry
-        for (int i = 0; i < refreshInterval && running; ++i) {
-          std::this_thread::sleep_for(1s);
-        }
+        fmt::print(fg(fmt::color::gray), "Retrying in {}...\n",
+                   formatInterval(refreshInterval));
+        if (!scheduler.waitNext()) break;
       }
     }
+    latency.jitter.add(scheduler.jitter());
+    return finishLatencyReport(0, true);
 
   } catch (const std::exception& e) {
     fmt::print(fg(fmt::color::red), "Fatal error: {}\n", e.what());
+    if (connections) connections->discard();
     return 1;
   }
 
@@ -0,0 +1,521 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/outputSink.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+char* appendText(char* out, std::string_view text) {
+  std::memcpy(out, text.data(), text.size());
+  return out + text.size();
+}
+
+char* appendInt(char* out, std::int64_t value) {
+  const fmt::format_int digits(value);
+  return appendText(out, std::string_view(digits.data(), digits.size()));
+}
+
+// `{"tick":N,"ts":N` plus `,"age_ms":N` when the age is known.
+char* appendStamp(char* out, const OutputSink::TickStamp& stamp) {
+  out = appendText(out, "{\"tick\":");
+  out = appendInt(out, static_cast<std::int64_t>(stamp.tick));
+  out = appendText(out, ",\"ts\":");
+  out = appendInt(out, stamp.ts);
+  if (stamp.ageMs < 0) return out;
+  out = appendText(out, ",\"age_ms\":");
+  return appendInt(out, stamp.ageMs);
+}
+
+// `tick,ts,age_ms`, age_ms left empty when unknown.
+char* appendCsvStamp(char* out, const OutputSink::TickStamp& stamp) {
+  out = appendInt(out, static_cast<std::int64_t>(stamp.tick));
+  *out++ = ',';
+  out = appendInt(out, stamp.ts);
+  *out++ = ',';
+  if (stamp.ageMs >= 0) out = appendInt(out, stamp.ageMs);
+  return out;
+}
+
+// Little-endian `bytes` low bytes of `value`.
+char* put(char* out, std::uint64_t value, int bytes = 8) {
+  for (int b = 0; b < bytes; ++b) {
+    *out++ = static_cast<char>((value >> (8 * b)) & 0xFF);
+  }
+  return out;
+}
+
+// `path` empty or "-" is stdout.
+std::FILE* openOutput(OutputFormat format, const std::string& path) {
+  if (path.empty() || path == "-") return stdout;
+  std::FILE* out =
+      std::fopen(path.c_str(), format == OutputFormat::Binary ? "wb" : "w");
+  if (out == nullptr) {
+    throw std::runtime_error("Cannot open output file: " + path);
+  }
+  return out;
+}
+
+// A CSV field per RFC 4180: quoted, with quotes doubled, if it holds a
+// comma, quote or line break. Needs room for 2 * text.size() + 2.
+char* appendCsvField(char* out, std::string_view text) {
+  if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+    return appendText(out, text);
+  }
+  *out++ = '"';
+  for (char c : text) {
+    if (c == '"') *out++ = '"';
+    *out++ = c;
+  }
+  *out++ = '"';
+  return out;
+}
+
+// Binary records carry a symbol in 8 NUL-padded bytes. A longer one is
+// refused rather than cut, since cut names can collide.
+constexpr std::size_t BINARY_SYMBOL_BYTES = 8;
+
+void checkBinarySymbol(std::string_view symbol) {
+  if (symbol.size() > BINARY_SYMBOL_BYTES) {
+    throw std::runtime_error("Symbol '" + std::string(symbol) +
+                             "' is longer than 8 bytes, which the bin "
+                             "format cannot hold (use ndjson or csv)");
+  }
+}
+
+char* appendBinarySymbol(char* out, std::string_view symbol) {
+  std::memset(out, 0, BINARY_SYMBOL_BYTES);
+  std::memcpy(out, symbol.data(), symbol.size());
+  return out + BINARY_SYMBOL_BYTES;
+}
+
+// Worst case for one price-row record besides the symbol.
+constexpr std::size_t RECORD_SLACK = 160 + 4 * Price::MAX_CHARS;
+
+// The price fields in record order, with their DeltaField bit and name.
+struct FieldColumn {
+  DeltaField bit;
+  std::string_view name;
+  std::pmr::vector<Price> Snapshot::*prices;
+};
+constexpr FieldColumn FIELDS[] = {
+    {DELTA_M15, "15m", &Snapshot::m15},
+    {DELTA_LAST, "last", &Snapshot::last},
+    {DELTA_BUY, "buy", &Snapshot::buy},
+    {DELTA_SELL, "sell", &Snapshot::sell},
+};
+
+class NdjsonSink : public OutputSink {
+ public:
+  NdjsonSink(std::FILE* out, std::size_t flushEvery,
+             std::size_t deltaKeyframeEvery)
+      : OutputSink(out, flushEvery, deltaKeyframeEvery) {}
+
+ protected:
+  void writeRecords(const Snapshot& snapshot,
+                    const TickStamp& stamp) override {
+    for (std::size_t i = 0; i < snapshot.size(); ++i) {
+      char* p =
+          this->writer.reserve(RECORD_SLACK + snapshot.symbols[i].size());
+      p = appendStamp(p, stamp);
+      p = appendText(p, ",\"symbol\":\"");
+      p = appendText(p, snapshot.symbols[i]);
+      p = appendText(p, "\",\"15m\":");
+      p = snapshot.m15[i].formatTo(p);
+      p = appendText(p, ",\"last\":");
+      p = snapshot.last[i].formatTo(p);
+      p = appendText(p, ",\"buy\":");
+      p = snapshot.buy[i].formatTo(p);
+      p = appendText(p, ",\"sell\":");
+      p = snapshot.sell[i].formatTo(p);
+      p = appendText(p, "}\n");
+      this->writer.commit(p);
+    }
+  }
+
+  void writeDelta(const Snapshot& snapshot, const DeltaFrame& frame,
+                  const TickStamp& stamp) override {
+    for (std::size_t k = 0; k < frame.size(); ++k) {
+      const std::uint32_t i = frame.ids[k];
+      char* p =
+          this->writer.reserve(RECORD_SLACK + snapshot.symbols[i].size());
+      p = appendStamp(p, stamp);
+      p = appendText(p, ",\"id\":");
+      p = appendInt(p, i);
+      if (frame.keyframe) {
+        p = appendText(p, ",\"key\":true,\"symbol\":\"");
+        p = appendText(p, snapshot.symbols[i]);
+        *p++ = '"';
+      }
+      for (const FieldColumn& field : FIELDS) {
+        if ((frame.fields[k] & field.bit) == 0) continue;
+        p = appendText(p, ",\"");
+        p = appendText(p, field.name);
+        p = appendText(p, "\":");
+        p = (snapshot.*field.prices)[i].formatTo(p);
+      }
+      p = appendText(p, "}\n");
+      this->writer.commit(p);
+    }
+  }
+};
+
+class CsvSink : public OutputSink {
+ public:
+  CsvSink(std::FILE* out, std::size_t flushEvery,
+          std::size_t deltaKeyframeEvery)
+      : OutputSink(out, flushEvery, deltaKeyframeEvery) {
+    this->writer.append(this->deltas()
+                            ? "tick,ts,age_ms,kind,id,symbol,15m,last,buy,sell\n"
+                            : "tick,ts,age_ms,symbol,15m,last,buy,sell\n");
+  }
+
+ protected:
+  void writeRecords(const Snapshot& snapshot,
+                    const TickStamp& stamp) override {
+    for (std::size_t i = 0; i < snapshot.size(); ++i) {
+      char* p = this->writer.reserve(RECORD_SLACK +
+                                     2 * snapshot.symbols[i].size());
+      p = appendCsvStamp(p, stamp);
+      *p++ = ',';
+      p = appendCsvField(p, snapshot.symbols[i]);
+      *p++ = ',';
+      p = snapshot.m15[i].formatTo(p);
+      *p++ = ',';
+      p = snapshot.last[i].formatTo(p);
+      *p++ = ',';
+      p = snapshot.buy[i].formatTo(p);
+      *p++ = ',';
+      p = snapshot.sell[i].formatTo(p);
+      *p++ = '\n';
+      this->writer.commit(p);
+    }
+  }
+
+  // Keyframe rows are kind K and carry the symbol; delta rows are kind D
+  // and leave the symbol and every unchanged field empty.
+  void writeDelta(const Snapshot& snapshot, const DeltaFrame& frame,
+                  const TickStamp& stamp) override {
+    for (std::size_t k = 0; k < frame.size(); ++k) {
+      const std::uint32_t i = frame.ids[k];
+      char* p = this->writer.reserve(RECORD_SLACK +
+                                     2 * snapshot.symbols[i].size());
+      p = appendCsvStamp(p, stamp);
+      p = appendText(p, frame.keyframe ? ",K," : ",D,");
+      p = appendInt(p, i);
+      *p++ = ',';
+      if (frame.keyframe) p = appendCsvField(p, snapshot.symbols[i]);
+      for (const FieldColumn& field : FIELDS) {
+        *p++ = ',';
+        if (frame.fields[k] & field.bit) {
+          p = (snapshot.*field.prices)[i].formatTo(p);
+        }
+      }
+      *p++ = '\n';
+      this->writer.commit(p);
+    }
+  }
+};
+
+// Fixed 64-byte little-endian records after an 8-byte "BTCXBIN2" header:
+// u64 tick, i64 ts_ms, i64 age_ms (-1 = unknown), char[8] symbol (NUL
+// padded), i64 cents x4 (15m, last, buy, sell).
+//
+// A symbol longer than 8 bytes fails the whole tick before any of it is
+// written, so the stream never holds a partial block.
+//
+// Delta streams start with "BTCXDLT2" instead and hold one block per tick:
+// u64 tick, i64 ts_ms, i64 age_ms, u32 count, u8 keyframe, then `count`
+// entries of u32 id, u8 field mask (DeltaField bits), char[8] symbol on
+// keyframes only, and one i64 cents per set bit in 15m, last, buy, sell
+// order.
+class BinarySink : public OutputSink {
+ public:
+  static constexpr std::size_t RECORD_BYTES = 64;
+  static constexpr std::size_t DELTA_HEADER_BYTES = 29;
+  static constexpr std::size_t DELTA_ENTRY_MAX_BYTES = 45;
+
+  BinarySink(std::FILE* out, std::size_t flushEvery,
+             std::size_t deltaKeyframeEvery)
+      : OutputSink(out, flushEvery, deltaKeyframeEvery) {
+    this->writer.append(this->deltas() ? "BTCXDLT2" : "BTCXBIN2");
+  }
+
+ protected:
+  void writeRecords(const Snapshot& snapshot,
+                    const TickStamp& stamp) override {
+    this->checkSymbols(snapshot);
+    for (std::size_t i = 0; i < snapshot.size(); ++i) {
+      char* p = this->writer.reserve(RECORD_BYTES);
+      p = put(p, stamp.tick);
+      p = put(p, static_cast<std::uint64_t>(stamp.ts));
+      p = put(p, static_cast<std::uint64_t>(stamp.ageMs));
+      p = appendBinarySymbol(p, snapshot.symbols[i]);
+      p = put(p, static_cast<std::uint64_t>(snapshot.m15[i].cents()));
+      p = put(p, static_cast<std::uint64_t>(snapshot.last[i].cents()));
+      p = put(p, static_cast<std::uint64_t>(snapshot.buy[i].cents()));
+      p = put(p, static_cast<std::uint64_t>(snapshot.sell[i].cents()));
+      this->writer.commit(p);
+    }
+  }
+
+  void writeDelta(const Snapshot& snapshot, const DeltaFrame& frame,
+                  const TickStamp& stamp) override {
+    if (frame.keyframe) {
+      try {
+        this->checkSymbols(snapshot);
+      } catch (const std::exception&) {
+        // The ids of a keyframe never written mean nothing to a reader.
+        this->delta->forceKeyframe();
+        throw;
+      }
+    }
+    char* p = this->writer.reserve(DELTA_HEADER_BYTES);
+    p = put(p, stamp.tick);
+    p = put(p, static_cast<std::uint64_t>(stamp.ts));
+    p = put(p, static_cast<std::uint64_t>(stamp.ageMs));
+    p = put(p, static_cast<std::uint32_t>(frame.size()), 4);
+    *p++ = frame.keyframe ? 1 : 0;
+    this->writer.commit(p);
+    for (std::size_t k = 0; k < frame.size(); ++k) {
+      const std::uint32_t i = frame.ids[k];
+      p = this->writer.reserve(DELTA_ENTRY_MAX_BYTES);
+      p = put(p, i, 4);
+      *p++ = static_cast<char>(frame.fields[k]);
+      if (frame.keyframe) p = appendBinarySymbol(p, snapshot.symbols[i]);
+      for (const FieldColumn& field : FIELDS) {
+        if ((frame.fields[k] & field.bit) == 0) continue;
+        const Price price = (snapshot.*field.prices)[i];
+        p = put(p, static_cast<std::uint64_t>(price.cents()));
+      }
+      this->writer.commit(p);
+    }
+  }
+
+ private:
+  // Every symbol of the snapshot, skipped while the set is the one checked
+  // last time.
+  void checkSymbols(const Snapshot& snapshot) {
+    if (this->checked && snapshot.symbolsHash == this->checkedHash) return;
+    for (const auto& symbol : snapshot.symbols) checkBinarySymbol(symbol);
+    this->checked = true;
+    this->checkedHash = snapshot.symbolsHash;
+  }
+
+  bool checked = false;
+  std::uint64_t checkedHash = 0;
+};
+}  // namespace
+
+BatchWriter::BatchWriter(std::FILE* out, std::size_t capacity)
+    : out(out), buffer(capacity) {}
+
+BatchWriter::~BatchWriter() {
+  try {
+    this->flush();
+  } catch (const std::exception&) {
+    // Nothing sensible left to do with a failed final write.
+  }
+  if (this->out != stdout) std::fclose(this->out);
+}
+
+void BatchWriter::drain() {
+  if (this->used == 0) return;
+  if (std::fwrite(this->buffer.data(), 1, this->used, this->out) !=
+      this->used) {
+    this->used = 0;
+    throw std::runtime_error("Failed to write output");
+  }
+  this->written += this->used;
+  this->used = 0;
+}
+
+char* BatchWriter::reserve(std::size_t bytes) {
+  if (this->buffer.size() - this->used < bytes) {
+    this->drain();
+    if (this->buffer.size() < bytes) this->buffer.resize(bytes);
+  }
+  return this->buffer.data() + this->used;
+}
+
+void BatchWriter::append(std::string_view text) {
+  this->commit(appendText(this->reserve(text.size()), text));
+}
+
+void BatchWriter::flush() {
+  this->drain();
+  std::fflush(this->out);
+}
+
+OutputSink::OutputSink(std::FILE* out, std::size_t flushEvery,
+                       std::size_t deltaKeyframeEvery)
+    : writer(out), flushEvery(flushEvery) {
+  if (deltaKeyframeEvery != 0) {
+    this->delta = std::make_unique<DeltaEncoder>(deltaKeyframeEvery);
+  }
+}
+
+void OutputSink::write(const Snapshot& snapshot) {
+  ++this->tick;
+  TickStamp stamp;
+  stamp.tick = this->tick;
+  stamp.ts = std::chrono::duration_cast<std::chrono::milliseconds>(
+                 snapshot.fetchedAt.time_since_epoch())
+                 .count();
+  if (snapshot.freshness.known()) {
+    // A source clock running ahead of ours is read as brand new data.
+    stamp.ageMs = std::max<std::int64_t>(
+        snapshot.freshness.ageMillis(std::chrono::system_clock::now()), 0);
+  }
+  if (this->candles) this->candles->write(snapshot);
+  if (this->delta) {
+    const DeltaFrame& frame = this->delta->encode(snapshot);
+    this->writeDelta(snapshot, frame, stamp);
+    this->recordCount += frame.size();
+  } else {
+    this->writeRecords(snapshot, stamp);
+    this->recordCount += snapshot.size();
+  }
+  if (this->flushEvery != 0 && this->tick % this->flushEvery == 0) {
+    this->writer.flush();
+  }
+}
+
+void OutputSink::advance(std::chrono::system_clock::time_point now) {
+  if (this->candles) this->candles->advance(now);
+}
+
+void OutputSink::flush() {
+  this->writer.flush();
+  if (this->candles) this->candles->flush();
+}
+
+OutputFormat OutputSink::parseFormat(std::string_view name) {
+  if (name == "ndjson") return OutputFormat::Ndjson;
+  if (name == "csv") return OutputFormat::Csv;
+  if (name == "bin") return OutputFormat::Binary;
+  throw std::invalid_argument("Unknown output format '" + std::string(name) +
+                              "' (expected ndjson, csv or bin)");
+}
+
+std::unique_ptr<OutputSink> OutputSink::create(
+    OutputFormat format, const std::string& path, std::size_t flushEvery,
+    std::size_t deltaKeyframeEvery) {
+  std::FILE* out = openOutput(format, path);
+  switch (format) {
+    case OutputFormat::Csv:
+      return std::make_unique<CsvSink>(out, flushEvery,
+                                          deltaKeyframeEvery);
+    case OutputFormat::Binary:
+      return std::make_unique<BinarySink>(out, flushEvery,
+                                          deltaKeyframeEvery);
+    case OutputFormat::Ndjson:
+    default:
+      return std::make_unique<NdjsonSink>(out, flushEvery,
+                                          deltaKeyframeEvery);
+  }
+}
+
+CandleSink::CandleSink(OutputFormat format, const std::string& path,
+                       std::size_t keep)
+    : format(format), writer(openOutput(format, path)), candles(keep) {
+  if (format == OutputFormat::Csv) {
+    this->writer.append("candle,symbol,start,open,high,low,close,ticks\n");
+  } else if (format == OutputFormat::Binary) {
+    this->writer.append("BTCXCDL1");
+  }
+}
+
+CandleSink::~CandleSink() {
+  try {
+    this->closed.clear();
+    this->candles.closeAll(this->closed);
+    this->writeClosed();
+  } catch (...) {
+    // Nowhere left to report it; the closed candles were written already.
+  }
+}
+
+void CandleSink::write(const Snapshot& snapshot) {
+  this->closed.clear();
+  this->candles.update(snapshot, this->closed);
+  this->writeClosed();
+}
+
+void CandleSink::advance(std::chrono::system_clock::time_point now) {
+  this->closed.clear();
+  this->candles.advance(now, this->closed);
+  this->writeClosed();
+}
+
+// Candles close together at a boundary, so a tick writes none or a burst;
+// the burst is flushed at once rather than held for --flush-every.
+void CandleSink::writeClosed() {
+  if (this->closed.empty()) return;
+  if (this->format == OutputFormat::Binary) {
+    for (const ClosedCandle& entry : this->closed) {
+      checkBinarySymbol(this->candles.symbol(entry.symbol));
+    }
+  }
+  for (const ClosedCandle& entry : this->closed) {
+    const std::string& symbol = this->candles.symbol(entry.symbol);
+    const CandleResolution& resolution = CANDLE_RESOLUTIONS[entry.resolution];
+    const Candle& candle = entry.candle;
+    const std::int64_t start = candle.startMillis(entry.resolution);
+    char* p = this->writer.reserve(RECORD_SLACK + 2 * symbol.size());
+    switch (this->format) {
+      case OutputFormat::Binary: {
+        p = put(p, static_cast<std::uint64_t>(start));
+        p = put(p, static_cast<std::uint64_t>(resolution.length.count()), 4);
+        p = put(p, candle.ticks, 4);
+        p = appendBinarySymbol(p, symbol);
+        for (Price price : {candle.open, candle.high, candle.low,
+                            candle.close}) {
+          p = put(p, static_cast<std::uint64_t>(price.cents()));
+        }
+        break;
+      }
+      case OutputFormat::Csv:
+        p = appendText(p, resolution.name);
+        *p++ = ',';
+        p = appendCsvField(p, symbol);
+        *p++ = ',';
+        p = appendInt(p, start);
+        for (Price price : {candle.open, candle.high, candle.low,
+                            candle.close}) {
+          *p++ = ',';
+          p = price.formatTo(p);
+        }
+        *p++ = ',';
+        p = appendInt(p, candle.ticks);
+        *p++ = '\n';
+        break;
+      case OutputFormat::Ndjson:
+      default:
+        p = appendText(p, "{\"candle\":\"");
+        p = appendText(p, resolution.name);
+        p = appendText(p, "\",\"symbol\":\"");
+        p = appendText(p, symbol);
+        p = appendText(p, "\",\"start\":");
+        p = appendInt(p, start);
+        p = appendText(p, ",\"open\":");
+        p = candle.open.formatTo(p);
+        p = appendText(p, ",\"high\":");
+        p = candle.high.formatTo(p);
+        p = appendText(p, ",\"low\":");
+        p = candle.low.formatTo(p);
+        p = appendText(p, ",\"close\":");
+        p = candle.close.formatTo(p);
+        p = appendText(p, ",\"ticks\":");
+        p = appendInt(p, candle.ticks);
+        p = appendText(p, "}\n");
+        break;
+    }
+    this->writer.commit(p);
+  }
+  this->recordCount += this->closed.size();
+  this->writer.flush();
+}
@@ -0,0 +1,159 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/pipeline.h"
+
+#include <fmt/format.h>
+
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "../include/trace.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double millis(std::chrono::nanoseconds ns) {
+  return std::chrono::duration<double, std::milli>(ns).count();
+}
+
+template <class T>
+void printQueue(std::FILE* out, std::string_view name,
+                const SpscQueue<T>& queue) {
+  const auto s = queue.stats();
+  fmt::print(out,
+             "  {:<16} pushed {}, popped {}, dropped {}, depth mean {:.2f} "
+             "max {}/{}, blocked {:.1f} ms\n",
+             name, s.pushed, s.popped, s.dropped,
+             s.pushed == 0 ? 0.0
+                           : static_cast<double>(s.depthSum) /
+                                 static_cast<double>(s.pushed),
+             s.maxDepth, queue.capacity(), millis(s.blocked));
+}
+}  // namespace
+
+OverflowPolicy PipelineOptions::parseOverflow(std::string_view name) {
+  if (name == "block") return OverflowPolicy::Block;
+  if (name == "drop-oldest") return OverflowPolicy::DropOldest;
+  throw std::invalid_argument("Unknown overflow policy '" + std::string(name) +
+                              "' (expected block or drop-oldest)");
+}
+
+Pipeline::Pipeline(TickerClient& ticker, const TickerDecoder& decoder,
+                   PipelineOptions options, LatencyReport& latency)
+    : ticker(ticker),
+      decoder(decoder),
+      options(options),
+      fetched(options.depth, options.overflow),
+      decoded(options.depth, options.overflow),
+      latency(latency) {}
+
+void Pipeline::networkStage(bool realTime) {
+  TickScheduler scheduler(this->options.interval,
+                          this->options.alignToWallClock);
+  std::uint64_t tick = 0;
+  do {
+    const auto start = Clock::now();
+    try {
+      RawTick raw{++tick, start, this->ticker.fetchPayload(),
+                  this->ticker.lastFreshness()};
+      const auto elapsed = Clock::now() - start;
+      this->network.busy += elapsed;
+      this->latency.fetch.record(elapsed);
+      ++this->network.items;
+      if (!this->fetched.push(std::move(raw))) break;
+    } catch (const std::exception& e) {
+      this->network.busy += Clock::now() - start;
+      ++this->network.errors;
+      fmt::print(stderr, "Error fetching data: {}\n", e.what());
+    }
+    if (!realTime) break;
+    // Same absolute-deadline cadence as the serial loop, overruns skipped.
+  } while (scheduler.waitNext());
+  this->latency.jitter.add(scheduler.jitter());
+  this->fetched.close();
+}
+
+void Pipeline::decodeStage() {
+  RawTick raw;
+  while (this->fetched.pop(raw)) {
+    const auto start = Clock::now();
+    try {
+      DecodedTick out;
+      out.tick = raw.tick;
+      out.started = raw.started;
+      this->ticker.decode(this->decoder,
+                          TickerClient::validateAndCleanJson(raw.body),
+                          out.snapshot);
+      out.snapshot.freshness = raw.freshness;
+      TickerClient::recycle(std::move(raw.body));
+      const auto elapsed = Clock::now() - start;
+      this->decoding.busy += elapsed;
+      this->latency.decode.record(elapsed);
+      ++this->decoding.items;
+      if (!this->decoded.push(std::move(out))) break;
+    } catch (const std::exception& e) {
+      this->decoding.busy += Clock::now() - start;
+      ++this->decoding.errors;
+      fmt::print(stderr, "Skipping bad payload on tick {}: {}\n", raw.tick,
+                 e.what());
+    }
+  }
+  this->decoded.close();
+}
+
+void Pipeline::outputStage(const Output& output) {
+  DecodedTick tick;
+  while (this->decoded.pop(tick)) {
+    const auto start = Clock::now();
+    try {
+      TRACE_SPAN("output");
+      output(tick.snapshot);
+      ++this->writing.items;
+      const auto done = Clock::now();
+      this->latency.output.record(done - start);
+      this->latency.tick.record(done - tick.started);
+      if (tick.snapshot.freshness.known()) {
+        this->latency.age.record(tick.snapshot.freshness.ageAt(
+            std::chrono::system_clock::now()));
+      }
+    } catch (const std::exception& e) {
+      ++this->writing.errors;
+      fmt::print(stderr, "Output failed on tick {}: {}\n", tick.tick,
+                 e.what());
+    }
+    this->writing.busy += Clock::now() - start;
+  }
+}
+
+void Pipeline::run(const Output& output, bool realTime) {
+  std::thread writer([this, &output] {
+    Tracer::nameThread("pipeline output");
+    this->outputStage(output);
+  });
+  std::thread parser([this] {
+    Tracer::nameThread("pipeline decode");
+    this->decodeStage();
+  });
+  std::thread fetcher([this, realTime] {
+    Tracer::nameThread("pipeline fetch");
+    this->networkStage(realTime);
+  });
+  fetcher.join();
+  parser.join();
+  writer.join();
+}
+
+void Pipeline::printMetrics(std::FILE* out) const {
+  fmt::print(out, "Pipeline ({} per queue, {}):\n", this->fetched.capacity(),
+             this->options.overflow == OverflowPolicy::Block ? "block"
+                                                             : "drop-oldest");
+  printQueue(out, "fetch -> decode", this->fetched);
+  printQueue(out, "decode -> output", this->decoded);
+  auto stage = [out](std::string_view name, const StageMetrics& m) {
+    fmt::print(out, "  {:<16} {} items, {} errors, busy {:.1f} ms\n", name,
+               m.items, m.errors, millis(m.busy));
+  };
+  stage("fetch", this->network);
+  stage("decode", this->decoding);
+  stage("output", this->writing);
+}
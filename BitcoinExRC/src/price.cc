@@ -0,0 +1,130 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/price.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+// "00" "01" ... "99": two digits per lookup instead of a divide per digit.
+constexpr char DIGIT_PAIRS[] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334"
+    "3536373839404142434445464748495051525354555657585960616263646566676869"
+    "707172737475767778798081828384858687888990919293949596979899";
+
+// Integer part limit keeping units * SCALE + cents inside int64.
+constexpr int MAX_INTEGER_DIGITS = 16;
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+}  // namespace
+
+Price Price::fromDouble(double value) {
+  const double cents = std::round(value * SCALE);
+  if (!std::isfinite(cents) || std::fabs(cents) > 9.2e18) {
+    throw std::out_of_range("Price out of range");
+  }
+  return Price(static_cast<std::int64_t>(cents));
+}
+
+std::from_chars_result Price::fromChars(const char* first, const char* last,
+                                        Price& out) {
+  const char* p = first;
+  const bool negative = p != last && *p == '-';
+  if (negative) ++p;
+
+  // Integer part: from_chars does the digit loop, we bound the length.
+  std::uint64_t units = 0;
+  auto [integerEnd, ec] = std::from_chars(p, last, units);
+  if (ec == std::errc::invalid_argument) return {first, ec};
+  if (ec != std::errc{} || integerEnd - p > MAX_INTEGER_DIGITS) {
+    return {integerEnd, std::errc::result_out_of_range};
+  }
+  p = integerEnd;
+
+  // Fraction: two digits kept, the third decides rounding, rest skipped.
+  std::uint64_t fraction = 0;
+  bool roundUp = false;
+  if (p != last && *p == '.') {
+    const char* digits = ++p;
+    while (p != last && isDigit(*p)) ++p;
+    const std::ptrdiff_t count = p - digits;
+    if (count == 0) return {p, std::errc::invalid_argument};
+    fraction = static_cast<std::uint64_t>(digits[0] - '0') * 10;
+    if (count > 1) fraction += static_cast<std::uint64_t>(digits[1] - '0');
+    if (count > 2) roundUp = digits[2] >= '5';
+  }
+
+  if (p != last && (*p == 'e' || *p == 'E')) {
+    // Exponent notation never shows up in the ticker; take the slow road.
+    double value = 0;
+#if defined(__cpp_lib_to_chars)
+    auto parsed = std::from_chars(first, last, value);
+    if (parsed.ec != std::errc{}) return parsed;
+    p = parsed.ptr;
+#else
+    char buffer[64];
+    const auto length = static_cast<std::size_t>(last - first);
+    const std::size_t copied =
+        length < sizeof(buffer) ? length : sizeof(buffer) - 1;
+    std::memcpy(buffer, first, copied);
+    buffer[copied] = '\0';
+    char* parsedEnd = nullptr;
+    value = std::strtod(buffer, &parsedEnd);
+    if (parsedEnd == buffer) return {first, std::errc::invalid_argument};
+    p = first + (parsedEnd - buffer);
+#endif
+    try {
+      out = fromDouble(value);
+    } catch (const std::out_of_range&) {
+      return {p, std::errc::result_out_of_range};
+    }
+    return {p, std::errc{}};
+  }
+
+  const auto cents = static_cast<std::int64_t>(units * SCALE + fraction +
+                                               (roundUp ? 1 : 0));
+  out = Price(negative ? -cents : cents);
+  return {p, std::errc{}};
+}
+
+bool Price::parse(std::string_view text, Price& out) {
+  const char* last = text.data() + text.size();
+  auto [ptr, ec] = fromChars(text.data(), last, out);
+  return ec == std::errc{} && ptr == last;
+}
+
+char* Price::formatTo(char* out) const {
+  char buffer[MAX_CHARS];
+  char* p = buffer + MAX_CHARS;
+  std::uint64_t rest = this->value < 0
+                           ? 0 - static_cast<std::uint64_t>(this->value)
+                           : static_cast<std::uint64_t>(this->value);
+
+  p -= 2;
+  std::memcpy(p, DIGIT_PAIRS + (rest % 100) * 2, 2);
+  rest /= 100;
+  *--p = '.';
+  while (rest >= 100) {
+    p -= 2;
+    std::memcpy(p, DIGIT_PAIRS + (rest % 100) * 2, 2);
+    rest /= 100;
+  }
+  if (rest >= 10) {
+    p -= 2;
+    std::memcpy(p, DIGIT_PAIRS + rest * 2, 2);
+  } else {
+    *--p = static_cast<char>('0' + rest);
+  }
+  if (this->value < 0) *--p = '-';
+
+  const std::size_t length = static_cast<std::size_t>(buffer + MAX_CHARS - p);
+  std::memcpy(out, p, length);
+  return out + length;
+}
+
+std::string Price::toString() const {
+  char buffer[MAX_CHARS];
+  return std::string(buffer, this->formatTo(buffer));
+}
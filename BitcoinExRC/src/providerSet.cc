@@ -0,0 +1,72 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/providerSet.h"
+
+#include <stdexcept>
+
+ProviderSet::ProviderSet(const std::vector<std::string>& urls, TaskPool& pool,
+                         const TickerKind& kind)
+    : pool(pool) {
+  if (urls.empty()) throw std::invalid_argument("No ticker URL given");
+  for (const std::string& url : urls) {
+    this->providers.push_back(std::make_unique<Provider>(url, kind));
+  }
+}
+
+void ProviderSet::setMaxBody(std::size_t bytes) {
+  for (auto& provider : this->providers) provider->ticker->setMaxBody(bytes);
+}
+
+void ProviderSet::fetchSnapshot(const TickerDecoder& decoder, Snapshot& out) {
+  this->failures.clear();
+  if (this->providers.size() == 1) {
+    this->primary().fetchSnapshot(decoder, out);
+    this->slowest = this->primary().lastStageTimes();
+    return;
+  }
+
+  {
+    TaskGroup group(this->pool);
+    for (auto& provider : this->providers) {
+      group.run([&decoder, p = provider.get()] {
+        p->error.clear();
+        try {
+          p->ticker->fetchSnapshot(decoder, p->scratch);
+        } catch (const std::exception& e) {
+          p->scratch.clear();
+          p->error = e.what();
+        }
+      });
+    }
+    group.wait();
+  }
+
+  out.clear();
+  this->slowest = {};
+  bool any = false;
+  for (const auto& provider : this->providers) {
+    if (!provider->error.empty()) {
+      this->failures.push_back(provider->url + ": " + provider->error);
+      continue;
+    }
+    const TickerClient::StageTimes times = provider->ticker->lastStageTimes();
+    if (times.fetch + times.decode >
+        this->slowest.fetch + this->slowest.decode) {
+      this->slowest = times;
+    }
+    const Snapshot& part = provider->scratch;
+    if (!any) out.fetchedAt = part.fetchedAt;
+    any = true;
+    // The merge is only as fresh as its stalest known part.
+    if (part.freshness.known() &&
+        (!out.freshness.known() ||
+         part.freshness.sourceAt < out.freshness.sourceAt)) {
+      out.freshness = part.freshness;
+    }
+    for (std::size_t i = 0; i < part.size(); ++i) {
+      if (out.indexOf(part.symbols[i])) continue;
+      out.push(part.symbols[i], part.m15[i], part.last[i], part.buy[i],
+               part.sell[i]);
+    }
+  }
+  if (!any) throw std::runtime_error(this->failures.front());
+}
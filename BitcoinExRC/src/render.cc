@@ -0,0 +1,107 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/render.h"
+
+#include <fmt/color.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iterator>
+#include <string_view>
+
+std::string formatClockTime(std::chrono::system_clock::time_point at) {
+  auto time_t = std::chrono::system_clock::to_time_t(at);
+
+#ifdef _WIN32
+  // Use localtime_s on Windows
+  std::tm tm_buf;
+  localtime_s(&tm_buf, &time_t);
+  return fmt::format("{:02d}:{:02d}:{:02d}", tm_buf.tm_hour, tm_buf.tm_min,
+                     tm_buf.tm_sec);
+#else
+  // Use localtime on Unix-like systems
+  std::tm* tm_ptr = std::localtime(&time_t);
+  return fmt::format("{:02d}:{:02d}:{:02d}", tm_ptr->tm_hour, tm_ptr->tm_min,
+                     tm_ptr->tm_sec);
+#endif
+}
+
+std::string getCurrentTimeString() {
+  return formatClockTime(std::chrono::system_clock::now());
+}
+
+std::string formatInterval(std::chrono::milliseconds interval) {
+  if (interval < std::chrono::seconds(1)) {
+    return fmt::format("{}ms", interval.count());
+  }
+  return fmt::format("{}s", static_cast<double>(interval.count()) / 1000.0);
+}
+
+void renderTable(FrameBuffer& out, const Snapshot& data, int updateCount,
+                 std::chrono::milliseconds refreshInterval, bool stale,
+                 const AssetInfo& asset) {
+  using fmt::color;
+  using fmt::fg;
+  auto it = std::back_inserter(out);
+
+  // Header with update info
+  fmt::format_to(it, fg(color::yellow), "*");
+  if (stale) {
+    const auto age = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now() - data.fetchedAt);
+    fmt::format_to(it, fg(color::red), "STALE {} Rates ", asset.name);
+    fmt::format_to(it, fg(color::gray),
+                   "(cached at {}, {}s old, fetching live data...)\n",
+                   formatClockTime(data.fetchedAt), age.count());
+  } else {
+    fmt::format_to(it, fg(color::orange), "LIVE {} Rates ", asset.name);
+    fmt::format_to(it, fg(color::gray), "(Update #{} at {}", updateCount,
+                   getCurrentTimeString());
+    const Freshness& fresh = data.freshness;
+    if (fresh.known()) {
+      const auto age = std::chrono::duration_cast<std::chrono::milliseconds>(
+          fresh.ageAt(std::chrono::system_clock::now()));
+      fmt::format_to(it, fg(color::gray), ", data age {}",
+                     formatInterval(std::max(age, age.zero())));
+    }
+    if (fresh.serverDated) {
+      fmt::format_to(it, fg(color::gray), ", server clock {:+.1f}s",
+                     std::chrono::duration<double>(fresh.skew).count());
+    }
+    fmt::format_to(it, fg(color::gray), ")\n");
+  }
+  fmt::format_to(it, fg(color::yellow), "1 {} =\n\n", asset.code);
+
+  // Table header
+  fmt::format_to(it, fg(color::cyan),
+                 "{:<8}│ {:>12} │ {:>12} │ {:>12} │ {:>12}\n", "Symbol", "15m",
+                 "Last", "Buy", "Sell");
+  fmt::format_to(it, fg(color::light_blue), "{:-<65}\n", "");
+
+  // Table data
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    fmt::format_to(it, fg(color::green), "{:<8}",
+                   std::string_view(data.symbols[i]));
+    fmt::format_to(it, "│ ");
+    fmt::format_to(it, fg(color::white), "{:>12} │ {:>12} │ {:>12} │ {:>12}\n",
+                   data.m15[i], data.last[i], data.buy[i], data.sell[i]);
+  }
+
+  // Footer with instructions
+  fmt::format_to(it, "\n");
+  if (refreshInterval.count() > 0) {
+    fmt::format_to(it, fg(color::gray),
+                   "Press Ctrl+C to exit • Auto-refresh every {}\n",
+                   formatInterval(refreshInterval));
+  } else {
+    fmt::format_to(it, fg(color::gray),
+                   "Press Ctrl+C to exit • Streaming live updates\n");
+  }
+  fmt::format_to(it, fg(color::dark_gray), "{:-<65}\n", "");
+}
+
+void writeFrame(const FrameBuffer& frame, std::FILE* out) {
+  std::fwrite(frame.data(), 1, frame.size(), out);
+  std::fflush(out);
+}
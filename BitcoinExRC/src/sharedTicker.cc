@@ -0,0 +1,73 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/sharedTicker.h"
+
+#include "../include/trace.h"
+
+SharedTicker::SharedTicker(TickerClient& ticker, const TickerDecoder& decoder,
+                           std::chrono::milliseconds maxStaleness)
+    : ticker(ticker), decoder(decoder), maxStaleness(maxStaleness) {}
+
+std::shared_ptr<const Snapshot> SharedTicker::get() {
+  std::unique_lock<std::mutex> guard(this->lock);
+  ++this->counters.calls;
+  if (this->latest && this->maxStaleness.count() > 0 &&
+      std::chrono::steady_clock::now() - this->latestAt <=
+          this->maxStaleness) {
+    ++this->counters.cacheHits;
+    return this->latest;
+  }
+
+  if (this->inFlight) {
+    // Someone is already fetching: wait for that request to land.
+    ++this->counters.joined;
+    const std::uint64_t waitingFor = this->flight;
+    this->landed.wait(guard, [&] { return this->flight != waitingFor; });
+    if (this->flightError) std::rethrow_exception(this->flightError);
+    return this->latest;
+  }
+
+  this->inFlight = true;
+  ++this->counters.fetches;
+  guard.unlock();
+  // The transfer and decode run unlocked so cached() and stats() stay
+  // responsive; inFlight keeps every other get() off the curl handle.
+  std::shared_ptr<Snapshot> fresh;
+  std::exception_ptr error;
+  try {
+    TRACE_SPAN("single-flight fetch");
+    fresh = std::make_shared<Snapshot>();
+    this->ticker.fetchSnapshot(this->decoder, *fresh);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  guard.lock();
+  this->inFlight = false;
+  ++this->flight;
+  this->flightError = error;
+  if (error) {
+    ++this->counters.errors;
+  } else {
+    this->latest = std::move(fresh);
+    this->latestAt = std::chrono::steady_clock::now();
+  }
+  const std::shared_ptr<const Snapshot> result = this->latest;
+  guard.unlock();
+  this->landed.notify_all();
+  if (error) std::rethrow_exception(error);
+  return result;
+}
+
+std::shared_ptr<const Snapshot> SharedTicker::cached() const {
+  std::lock_guard<std::mutex> guard(this->lock);
+  return this->latest;
+}
+
+void SharedTicker::setMaxStaleness(std::chrono::milliseconds window) {
+  std::lock_guard<std::mutex> guard(this->lock);
+  this->maxStaleness = window;
+}
+
+SharedTicker::Stats SharedTicker::stats() const {
+  std::lock_guard<std::mutex> guard(this->lock);
+  return this->counters;
+}
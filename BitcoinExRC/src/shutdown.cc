@@ -0,0 +1,155 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/shutdown.h"
+
+#include <atomic>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
+#endif
+
+namespace {
+std::atomic<bool> shutdownRequested{false};
+#ifdef _WIN32
+HANDLE wakeEvent = nullptr;
+#else
+int wakePipe[2] = {-1, -1};
+#endif
+
+#ifdef __linux__
+// Per-thread CLOCK_MONOTONIC timer armed with absolute deadlines, so a
+// sleep ends at the deadline to the nanosecond instead of a rounded-up
+// millisecond poll() timeout. steady_clock is CLOCK_MONOTONIC on Linux.
+class DeadlineTimer {
+ public:
+  DeadlineTimer() : fd(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)) {}
+  ~DeadlineTimer() {
+    if (this->fd != -1) close(this->fd);
+  }
+  DeadlineTimer(const DeadlineTimer&) = delete;
+  DeadlineTimer& operator=(const DeadlineTimer&) = delete;
+
+  // Returns the fd to poll, or -1 if no timer is available.
+  int arm(std::chrono::steady_clock::time_point deadline) {
+    using namespace std::chrono;
+    if (this->fd == -1) return -1;
+    const auto since = deadline.time_since_epoch();
+    const auto secs = duration_cast<seconds>(since);
+    itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(secs.count());
+    spec.it_value.tv_nsec =
+        static_cast<long>(duration_cast<nanoseconds>(since - secs).count());
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+      spec.it_value.tv_nsec = 1;  // all-zero would disarm
+    }
+    if (timerfd_settime(this->fd, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+      return -1;
+    }
+    return this->fd;
+  }
+
+ private:
+  int fd;
+};
+#endif
+}  // namespace
+
+void initShutdownWakeup() {
+#ifdef _WIN32
+  if (wakeEvent == nullptr) {
+    wakeEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (wakeEvent == nullptr) {
+      throw std::runtime_error("Failed to create shutdown event");
+    }
+  }
+#else
+  if (wakePipe[0] != -1) return;
+  if (pipe(wakePipe) != 0) {
+    throw std::runtime_error("Failed to create shutdown pipe");
+  }
+  for (int fd : wakePipe) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+#endif
+}
+
+void notifyShutdownWakeup() {
+  shutdownRequested.store(true);
+#ifdef _WIN32
+  if (wakeEvent != nullptr) SetEvent(wakeEvent);
+#else
+  if (wakePipe[1] != -1) {
+    const char byte = 1;
+    // A full pipe already means a pending wakeup; nothing to handle.
+    [[maybe_unused]] auto written = write(wakePipe[1], &byte, 1);
+  }
+#endif
+}
+
+bool sleepUntilOrShutdown(std::chrono::steady_clock::time_point deadline) {
+  using namespace std::chrono;
+  while (!shutdownRequested.load()) {
+    const auto now = steady_clock::now();
+    if (now >= deadline) return true;
+    // Round up so we never wake just before the deadline and spin.
+    const auto wait = ceil<milliseconds>(deadline - now).count();
+#ifdef _WIN32
+    if (wakeEvent == nullptr) initShutdownWakeup();
+    WaitForSingleObject(wakeEvent, static_cast<DWORD>(wait));
+#else
+    if (wakePipe[0] == -1) initShutdownWakeup();
+    pollfd fds[2] = {{wakePipe[0], POLLIN, 0}, {-1, POLLIN, 0}};
+    int timeout = wait > 0x7fffffff ? 0x7fffffff : static_cast<int>(wait);
+#ifdef __linux__
+    thread_local DeadlineTimer timer;
+    fds[1].fd = timer.arm(deadline);
+    if (fds[1].fd != -1) timeout = -1;
+#endif
+    if (poll(fds, fds[1].fd == -1 ? 1 : 2, timeout) < 0 && errno != EINTR) {
+      throw std::runtime_error("poll() failed while sleeping");
+    }
+#endif
+  }
+  return false;
+}
+
+WakeReason waitReadableOrShutdown(
+    std::intptr_t socket, std::chrono::steady_clock::time_point deadline) {
+  using namespace std::chrono;
+  while (!shutdownRequested.load()) {
+    const auto now = steady_clock::now();
+    if (now >= deadline) return WakeReason::Deadline;
+    const auto wait = ceil<milliseconds>(deadline - now).count();
+#ifdef _WIN32
+    // WSAPoll cannot wait on the event, so wait in short slices.
+    WSAPOLLFD fd{static_cast<SOCKET>(socket), POLLRDNORM, 0};
+    const int slice = wait > 50 ? 50 : static_cast<int>(wait);
+    if (WSAPoll(&fd, 1, slice) > 0) return WakeReason::Readable;
+#else
+    if (wakePipe[0] == -1) initShutdownWakeup();
+    pollfd fds[2] = {{static_cast<int>(socket), POLLIN, 0},
+                     {wakePipe[0], POLLIN, 0}};
+    const int timeout = wait > 0x7fffffff ? 0x7fffffff : static_cast<int>(wait);
+    const int ready = poll(fds, 2, timeout);
+    if (ready < 0 && errno != EINTR) {
+      throw std::runtime_error("poll() failed while waiting for data");
+    }
+    if (ready > 0 && fds[0].revents != 0) return WakeReason::Readable;
+#endif
+  }
+  return WakeReason::Shutdown;
+}
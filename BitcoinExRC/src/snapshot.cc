@@ -0,0 +1,60 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/snapshot.h"
+
+#include <stdexcept>
+
+void Snapshot::clear() {
+  this->symbolsHash = EMPTY_SYMBOLS_HASH;
+  this->freshness = {};
+  this->symbols.clear();
+  this->m15.clear();
+  this->last.clear();
+  this->buy.clear();
+  this->sell.clear();
+}
+
+void Snapshot::reserve(std::size_t n) {
+  this->symbols.reserve(n);
+  this->m15.reserve(n);
+  this->last.reserve(n);
+  this->buy.reserve(n);
+  this->sell.reserve(n);
+}
+
+void Snapshot::push(std::string_view symbol, Price m15, Price last, Price buy,
+                    Price sell) {
+  this->symbols.emplace_back(symbol);
+  for (char c : symbol) {
+    this->symbolsHash = (this->symbolsHash ^ static_cast<unsigned char>(c)) *
+                        1099511628211ULL;
+  }
+  // Terminator, so {"AB","C"} and {"A","BC"} hash apart.
+  this->symbolsHash = (this->symbolsHash ^ 0xFFU) * 1099511628211ULL;
+  this->m15.push_back(m15);
+  this->last.push_back(last);
+  this->buy.push_back(buy);
+  this->sell.push_back(sell);
+}
+
+std::optional<std::size_t> Snapshot::indexOf(std::string_view symbol) const {
+  for (std::size_t i = 0; i < this->symbols.size(); ++i) {
+    if (this->symbols[i] == symbol) return i;
+  }
+  return std::nullopt;
+}
+
+Snapshot Snapshot::fromJson(const nlohmann::json& data) {
+  if (!data.is_object()) {
+    throw std::runtime_error("Ticker payload is not a JSON object");
+  }
+  Snapshot snapshot;
+  snapshot.reserve(data.size());
+  for (const auto& [symbol, info] : data.items()) {
+    snapshot.push(symbol, Price::fromDouble(info["15m"].get<double>()),
+                  Price::fromDouble(info["last"].get<double>()),
+                  Price::fromDouble(info["buy"].get<double>()),
+                  Price::fromDouble(info["sell"].get<double>()));
+  }
+  snapshot.fetchedAt = std::chrono::system_clock::now();
+  return snapshot;
+}
@@ -0,0 +1,265 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/snapshotCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr std::string_view MAGIC = "BTCXSNP1";
+
+void put(unsigned char* out, std::uint64_t value, int bytes = 8) {
+  for (int b = 0; b < bytes; ++b) {
+    out[b] = static_cast<unsigned char>((value >> (8 * b)) & 0xFF);
+  }
+}
+
+std::uint64_t get(const unsigned char* in, int bytes = 8) {
+  std::uint64_t value = 0;
+  for (int b = bytes; b-- > 0;) value = (value << 8) | in[b];
+  return value;
+}
+
+std::uint64_t fnv1a(const unsigned char* data, std::size_t size) {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (std::size_t i = 0; i < size; ++i) {
+    hash = (hash ^ data[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// Read-only view of a whole file, unmapped on destruction.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+    this->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                             nullptr);
+    if (this->file == INVALID_HANDLE_VALUE) return;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(this->file, &size) || size.QuadPart == 0) return;
+    this->mapping =
+        CreateFileMappingA(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (this->mapping == nullptr) return;
+    void* view = MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) return;
+    this->bytes = static_cast<const unsigned char*>(view);
+    this->length = static_cast<std::size_t>(size.QuadPart);
+#else
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      void* view = mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                        PROT_READ, MAP_PRIVATE, fd, 0);
+      if (view != MAP_FAILED) {
+        this->bytes = static_cast<const unsigned char*>(view);
+        this->length = static_cast<std::size_t>(info.st_size);
+      }
+    }
+    close(fd);  // the mapping keeps the file alive
+#endif
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() {
+#ifdef _WIN32
+    if (this->bytes != nullptr) UnmapViewOfFile(this->bytes);
+    if (this->mapping != nullptr) CloseHandle(this->mapping);
+    if (this->file != INVALID_HANDLE_VALUE) CloseHandle(this->file);
+#else
+    if (this->bytes != nullptr) {
+      munmap(const_cast<unsigned char*>(this->bytes), this->length);
+    }
+#endif
+  }
+
+  const unsigned char* data() const { return this->bytes; }
+  std::size_t size() const { return this->length; }
+
+ private:
+  const unsigned char* bytes = nullptr;
+  std::size_t length = 0;
+#ifdef _WIN32
+  HANDLE file = INVALID_HANDLE_VALUE;
+  HANDLE mapping = nullptr;
+#endif
+};
+}  // namespace
+
+SnapshotCache::SnapshotCache(std::string path) : file(std::move(path)) {
+  if (this->file.empty()) {
+    throw std::invalid_argument("Cache path cannot be empty");
+  }
+}
+
+std::string SnapshotCache::defaultPath(std::string_view asset) {
+  std::filesystem::path base;
+#ifdef _WIN32
+  if (const char* local = std::getenv("LOCALAPPDATA")) {
+    base = std::filesystem::path(local) / "BitcoinExRC";
+  }
+#else
+  if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    base = std::filesystem::path(xdg) / "bitcoinexrc";
+  } else if (const char* home = std::getenv("HOME"); home && *home) {
+    base = std::filesystem::path(home) / ".cache" / "bitcoinexrc";
+  }
+#endif
+  if (base.empty()) return {};
+  if (asset.empty()) return (base / "last.bin").string();
+  return (base / ("last-" + std::string(asset) + ".bin")).string();
+}
+
+void replaceFile(const std::string& path, const unsigned char* data,
+                 std::size_t size, std::string& temporary,
+                 std::string_view what) {
+  auto fail = [&](std::string_view verb, const std::string& detail) {
+    throw std::runtime_error(std::string(verb) + " " + std::string(what) +
+                             ": " + detail);
+  };
+#ifdef _WIN32
+  static std::atomic<unsigned> serial{0};
+  std::FILE* out = nullptr;
+  for (int attempt = 0; attempt < 100 && out == nullptr; ++attempt) {
+    temporary = path + "." + std::to_string(GetCurrentProcessId()) + "." +
+                std::to_string(serial++) + ".tmp";
+    // "x" fails instead of truncating a file another writer created.
+    out = std::fopen(temporary.c_str(), "wbx");
+  }
+  if (out == nullptr) fail("Cannot write", path);
+  const bool written = std::fwrite(data, 1, size, out) == size;
+  if (std::fclose(out) != 0 || !written) {
+    std::remove(temporary.c_str());
+    fail("Cannot write", temporary);
+  }
+  if (!MoveFileExA(temporary.c_str(), path.c_str(),
+                   MOVEFILE_REPLACE_EXISTING)) {
+    std::remove(temporary.c_str());
+    fail("Cannot replace", path);
+  }
+#else
+  // Plain descriptors rather than stdio, which would malloc a FILE and its
+  // buffer on every save.
+  temporary.assign(path);
+  temporary.append(".XXXXXX");
+  const int fd = mkostemp(temporary.data(), O_CLOEXEC);  // 0600, O_EXCL
+  if (fd < 0) fail("Cannot write", path);
+  bool written = true;
+  for (std::size_t done = 0; written && done < size;) {
+    const ssize_t n = write(fd, data + done, size - done);
+    if (n < 0 && errno == EINTR) continue;
+    written = n > 0;
+    if (written) done += static_cast<std::size_t>(n);
+  }
+  if (close(fd) != 0 || !written) {
+    unlink(temporary.c_str());
+    fail("Cannot write", temporary);
+  }
+  if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+    const int error = errno;
+    unlink(temporary.c_str());
+    fail("Cannot replace", std::strerror(error));
+  }
+#endif
+}
+
+void SnapshotCache::save(const Snapshot& snapshot) const {
+  // Encoded into the buffer of the previous save: at a steady symbol count
+  // a tick's save allocates nothing.
+  std::vector<unsigned char>& bytes = this->scratch.bytes;
+  bytes.resize(HEADER_BYTES + snapshot.size() * RECORD_BYTES);
+  std::uint32_t count = 0;
+  unsigned char* record = bytes.data() + HEADER_BYTES;
+  for (std::size_t i = 0; i < snapshot.size(); ++i) {
+    const std::string_view symbol = snapshot.symbols[i];
+    if (symbol.size() > MAX_SYMBOL) continue;  // no such fiat code
+    std::memset(record, 0, 16);
+    record[0] = static_cast<unsigned char>(symbol.size());
+    std::memcpy(record + 1, symbol.data(), symbol.size());
+    put(record + 16, static_cast<std::uint64_t>(snapshot.m15[i].cents()));
+    put(record + 24, static_cast<std::uint64_t>(snapshot.last[i].cents()));
+    put(record + 32, static_cast<std::uint64_t>(snapshot.buy[i].cents()));
+    put(record + 40, static_cast<std::uint64_t>(snapshot.sell[i].cents()));
+    record += RECORD_BYTES;
+    ++count;
+  }
+  bytes.resize(HEADER_BYTES + count * RECORD_BYTES);
+
+  const auto fetchedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             snapshot.fetchedAt.time_since_epoch())
+                             .count();
+  std::memcpy(bytes.data(), MAGIC.data(), MAGIC.size());
+  put(bytes.data() + 8, count, 4);
+  put(bytes.data() + 12, RECORD_BYTES, 4);
+  put(bytes.data() + 16, static_cast<std::uint64_t>(fetchedAt));
+  put(bytes.data() + 24, fnv1a(bytes.data() + HEADER_BYTES,
+                               bytes.size() - HEADER_BYTES));
+
+  if (!this->scratch.directoryReady) {
+    const std::filesystem::path target(this->file);
+    std::error_code ec;
+    if (target.has_parent_path()) {
+      std::filesystem::create_directories(target.parent_path(), ec);
+    }
+    this->scratch.directoryReady = true;
+  }
+  replaceFile(this->file, bytes.data(), bytes.size(),
+              this->scratch.temporary, "snapshot cache");
+}
+
+bool SnapshotCache::load(Snapshot& out, const SymbolFilter& filter) const {
+  const MappedFile mapped(this->file);
+  const unsigned char* bytes = mapped.data();
+  if (bytes == nullptr || mapped.size() < HEADER_BYTES ||
+      std::memcmp(bytes, MAGIC.data(), MAGIC.size()) != 0 ||
+      get(bytes + 12, 4) != RECORD_BYTES) {
+    return false;
+  }
+  const std::size_t count = get(bytes + 8, 4);
+  if (mapped.size() != HEADER_BYTES + count * RECORD_BYTES ||
+      get(bytes + 24) !=
+          fnv1a(bytes + HEADER_BYTES, count * RECORD_BYTES)) {
+    return false;
+  }
+
+  out.clear();
+  out.reserve(count);
+  const unsigned char* record = bytes + HEADER_BYTES;
+  for (std::size_t i = 0; i < count; ++i, record += RECORD_BYTES) {
+    const std::size_t length = record[0] > MAX_SYMBOL ? MAX_SYMBOL : record[0];
+    const std::string_view symbol(reinterpret_cast<const char*>(record + 1),
+                                  length);
+    if (!filter.accepts(symbol)) continue;
+    auto cents = [record](int offset) {
+      return Price::fromCents(static_cast<std::int64_t>(get(record + offset)));
+    };
+    out.push(symbol, cents(16), cents(24), cents(32), cents(40));
+  }
+  out.fetchedAt = std::chrono::system_clock::time_point(
+      std::chrono::milliseconds(static_cast<std::int64_t>(get(bytes + 16))));
+  return true;
+}
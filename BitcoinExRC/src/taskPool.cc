@@ -0,0 +1,160 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/taskPool.h"
+
+#include <algorithm>
+
+#include "../include/trace.h"
+
+namespace {
+// Which pool (if any) the current thread works for, and its queue index.
+thread_local const TaskPool* currentPool = nullptr;
+thread_local std::size_t currentIndex = 0;
+}  // namespace
+
+TaskPool::TaskPool(std::size_t workers) {
+  if (workers == 0) workers = std::thread::hardware_concurrency();
+  if (workers == 0) workers = 1;
+  for (std::size_t i = 0; i < workers; ++i) {
+    this->queues.push_back(std::make_unique<Queue>());
+  }
+  this->threads.reserve(workers);
+  for (std::size_t i = 0; i < workers; ++i) {
+    this->threads.emplace_back([this, i] { this->workerLoop(i); });
+  }
+}
+
+TaskPool::~TaskPool() {
+  {
+    std::lock_guard<std::mutex> guard(this->sleepLock);
+    this->stopping = true;
+  }
+  this->wake.notify_all();
+  for (std::thread& thread : this->threads) thread.join();
+}
+
+void TaskPool::TaskRing::pushBack(Task task) {
+  if (this->count == this->slots.size()) {
+    // Full: unroll into a ring twice the size, oldest first.
+    std::vector<Task> grown(
+        std::max<std::size_t>(16, 2 * this->slots.size()));
+    for (std::size_t i = 0; i < this->count; ++i) {
+      grown[i] = std::move(this->slots[(this->head + i) % this->slots.size()]);
+    }
+    this->slots = std::move(grown);
+    this->head = 0;
+  }
+  this->slots[(this->head + this->count) % this->slots.size()] =
+      std::move(task);
+  ++this->count;
+}
+
+Task TaskPool::TaskRing::popBack() {
+  --this->count;
+  const std::size_t last = (this->head + this->count) % this->slots.size();
+  return std::move(this->slots[last]);
+}
+
+Task TaskPool::TaskRing::popFront() {
+  Task task = std::move(this->slots[this->head]);
+  this->head = (this->head + 1) % this->slots.size();
+  --this->count;
+  return task;
+}
+
+void TaskPool::post(Task task) {
+  const std::size_t index =
+      currentPool == this
+          ? currentIndex
+          : this->nextQueue.fetch_add(1, std::memory_order_relaxed) %
+                this->queues.size();
+  {
+    // Counted under the queue lock, like the decrement in tryTake(), so the
+    // total never dips below what the deques hold.
+    std::lock_guard<std::mutex> guard(this->queues[index]->lock);
+    this->queued.fetch_add(1, std::memory_order_release);
+    this->queues[index]->tasks.pushBack(std::move(task));
+  }
+  // Taking the lock orders this against a worker that just found nothing
+  // and is about to sleep, so the notify cannot be lost.
+  { std::lock_guard<std::mutex> guard(this->sleepLock); }
+  this->wake.notify_one();
+}
+
+bool TaskPool::tryTake(std::size_t self, Task& out) {
+  if (this->queued.load(std::memory_order_acquire) == 0) return false;
+  const std::size_t count = this->queues.size();
+  // Own queue from the back, then everyone else's from the front.
+  {
+    Queue& own = *this->queues[self];
+    std::lock_guard<std::mutex> guard(own.lock);
+    if (!own.tasks.empty()) {
+      out = own.tasks.popBack();
+      this->queued.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  for (std::size_t k = 1; k < count; ++k) {
+    Queue& victim = *this->queues[(self + k) % count];
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if (!victim.tasks.empty()) {
+      out = victim.tasks.popFront();
+      this->queued.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TaskPool::runPending() {
+  const std::size_t self = currentPool == this ? currentIndex : 0;
+  Task task;
+  if (!this->tryTake(self, task)) return false;
+  try {
+    task();
+  } catch (...) {
+    // post() is fire and forget; submit()/TaskGroup capture their own.
+  }
+  return true;
+}
+
+void TaskPool::workerLoop(std::size_t index) {
+  currentPool = this;
+  currentIndex = index;
+  Tracer::nameThread("pool worker");
+  for (;;) {
+    if (this->runPending()) continue;
+    std::unique_lock<std::mutex> lock(this->sleepLock);
+    this->wake.wait(lock, [this] {
+      return this->stopping ||
+             this->queued.load(std::memory_order_acquire) > 0;
+    });
+    if (this->stopping && this->queued.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+  }
+}
+
+TaskGroup::~TaskGroup() {
+  try {
+    this->wait();
+  } catch (...) {
+    // Already reported by an explicit wait(), or nobody asked.
+  }
+}
+
+void TaskGroup::wait() {
+  std::unique_lock<std::mutex> guard(this->lock);
+  while (this->pending > 0) {
+    guard.unlock();
+    const bool helped = this->pool.runPending();
+    guard.lock();
+    if (helped) continue;
+    // Nothing left to help with: the rest is running on other workers.
+    this->done.wait(guard, [this] { return this->pending == 0; });
+  }
+  if (this->error) {
+    std::exception_ptr error = std::exchange(this->error, nullptr);
+    guard.unlock();
+    std::rethrow_exception(error);
+  }
+}
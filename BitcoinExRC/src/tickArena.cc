@@ -0,0 +1,6 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/tickArena.h"
+
+TickArena::TickArena(std::size_t bytes)
+    : storage(std::make_unique<std::byte[]>(bytes)),
+      arena(storage.get(), bytes, std::pmr::new_delete_resource()) {}
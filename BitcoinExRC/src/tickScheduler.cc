@@ -0,0 +1,82 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/tickScheduler.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "../include/shutdown.h"
+#include "../include/trace.h"
+
+TickScheduler::TickScheduler(std::chrono::nanoseconds interval,
+                             bool alignToWallClock)
+    : period(interval), due(Clock::now()) {
+  if (interval.count() <= 0) {
+    throw std::invalid_argument("Tick interval must be positive");
+  }
+  if (alignToWallClock) {
+    // Shift the monotonic anchor so that anchor + n * interval falls on a
+    // wall-clock multiple of the interval. Done once: afterwards the ticks
+    // follow CLOCK_MONOTONIC and ignore wall-clock steps.
+    const auto wall = std::chrono::system_clock::now().time_since_epoch();
+    const auto phase = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           wall) %
+                       interval;
+    this->due -= phase;
+  }
+}
+
+TickScheduler::Clock::time_point TickScheduler::next() {
+  const auto now = Clock::now();
+  this->due += this->period;
+  if (this->due <= now) {
+    // Overran one or more deadlines: jump to the first one still ahead.
+    const auto behind = (now - this->due) / this->period + 1;
+    this->missed += static_cast<std::uint64_t>(behind);
+    this->due += behind * this->period;
+  }
+  return this->due;
+}
+
+bool TickScheduler::wait() {
+  TRACE_SPAN("sleep");
+  if (!sleepUntilOrShutdown(this->due)) return false;
+  this->lateness.record(Clock::now() - this->due);
+  return true;
+}
+
+std::chrono::milliseconds TickScheduler::parseInterval(std::string_view text) {
+  const std::string original(text);
+  double scale = 1000.0;  // seconds by default
+  if (text.size() > 2 && text.substr(text.size() - 2) == "ms") {
+    scale = 1.0;
+    text.remove_suffix(2);
+  } else if (text.size() > 1 && text.back() == 's') {
+    text.remove_suffix(1);
+  }
+  // Plain decimals only: stod alone would also take "inf", "nan", hex and
+  // exponents, none of which is an interval anyone means.
+  const bool decimal =
+      !text.empty() &&
+      text.find_first_not_of("0123456789.") == std::string_view::npos;
+  std::size_t used = 0;
+  double value = 0;
+  try {
+    if (decimal) value = std::stod(std::string(text), &used);
+  } catch (const std::exception&) {
+    used = 0;
+  }
+  if (used == 0 || used != text.size() || !std::isfinite(value) ||
+      !(value > 0)) {
+    throw std::invalid_argument("Invalid interval '" + original +
+                                "' (e.g. 250ms, 2s, 1.5)");
+  }
+  // Checked before the cast, which is undefined past long long's range.
+  const double millis = value * scale;
+  if (millis > static_cast<double>(MAX_INTERVAL.count())) {
+    throw std::invalid_argument("Interval must be at most 24h");
+  }
+  const auto ms = static_cast<long long>(millis + 0.5);
+  if (ms < 1) throw std::invalid_argument("Interval must be at least 1ms");
+  return std::chrono::milliseconds(ms);
+}
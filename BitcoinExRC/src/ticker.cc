@@ -1,36 +1,42 @@
 //Copyright(c)2022 Vishal Ahirwar.
 #include <cstddef>
 #define NOMINMAX  // 👈 prevent Windows macro pollution
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <algorithm> // for std::min
 #include <string>
 
 #include"../include/bitcoin.h"
+#include "../include/ticker.h"
+#include "../include/trace.h"
 #include <stdexcept>
 #include <algorithm>
 #include <iostream>
 
 // Helper function to validate and clean JSON response
-std::string BitCoin::validateAndCleanJson(const std::string& rawData) {
+std::string_view TickerClient::validateAndCleanJson(std::string_view rawData) {
+    TRACE_SPAN("validate");
     if (rawData.empty()) {
         throw std::runtime_error("Empty response from API");
     }
     
-    // Remove any leading/trailing whitespace
-    std::string cleaned = rawData;
-    cleaned.erase(0, cleaned.find_first_not_of(" \t\n\r"));
-    cleaned.erase(cleaned.find_last_not_of(" \t\n\r") + 1);
+    // Remove any leading/trailing whitespace (a view, no copy of the body)
+    std::string_view cleaned = rawData;
+    const size_t first = cleaned.find_first_not_of(" \t\n\r");
+    cleaned.remove_prefix(first == std::string_view::npos ? cleaned.size() : first);
+    cleaned.remove_suffix(cleaned.size() - (cleaned.find_last_not_of(" \t\n\r") + 1));
     
     // Check if response starts and ends with expected JSON characters
     if (cleaned.empty() || (cleaned.front() != '{' && cleaned.front() != '[')) {
         throw std::runtime_error("Response doesn't start with valid JSON character: " + 
-                                cleaned.substr(0, std::min(static_cast<size_t>(50UL), cleaned.length())));
+                                std::string(cleaned.substr(0, std::min(static_cast<size_t>(50UL), cleaned.length()))));
     }
     
     if (cleaned.back() != '}' && cleaned.back() != ']') {
         size_t start_pos = (cleaned.length() >= 50) ? cleaned.length() - 50 : 0;
         throw std::runtime_error("Response appears truncated (doesn't end with } or ]). Last 50 chars: " + 
-                                cleaned.substr(start_pos));
+                                std::string(cleaned.substr(start_pos)));
     }
     
     // Check for common malformed patterns
@@ -46,35 +52,24 @@ std::string BitCoin::validateAndCleanJson(const std::string& rawData) {
         throw std::runtime_error("Found concatenated objects '}{' at position " + std::to_string(pos));
     }
     
-    // Log response details for debugging if it's around the problematic length
-    if (cleaned.length() > 2735 && cleaned.length() < 2800) {
-        std::cerr << "Debug: Response length is " << cleaned.length() 
-                  << ", chars around 2735: '" << cleaned.substr(2730, 20) << "'" << std::endl;
-    }
-    
     return cleaned;
 }
 
-BitCoin::json BitCoin::fetch()
+TickerClient::json TickerClient::fetch()
 {
     try {
         // Perform the HTTP fetch
         CURLcode result = this->curlHandle.fetch();
         
         // Get the raw response data
-        std::string rawData = this->curlHandle.getFetchedData();
-        
-        // If we're having issues, print debug info
-        if (rawData.length() > 2700 && rawData.length() < 2800) {
-            std::cerr << "Debug: Suspicious response length, printing curl debug info:" << std::endl;
-            this->curlHandle.printDebugInfo();
-        }
+        const std::string& rawData = this->curlHandle.getFetchedData();
         
         // Validate and clean the JSON
-        std::string cleanedJson = validateAndCleanJson(rawData);
+        std::string_view cleanedJson = validateAndCleanJson(rawData);
         
         // Attempt to parse the JSON with detailed error reporting
         try {
+            TRACE_SPAN("parse");
             return json::parse(cleanedJson);
         } catch (const nlohmann::json::parse_error& e) {
             // Print debug info on parse errors
@@ -88,7 +83,7 @@ BitCoin::json BitCoin::fetch()
             if (e.byte < cleanedJson.length()) {
                 size_t start = (e.byte >= 20) ? e.byte - 20 : 0;
                 size_t contextLength = std::min(static_cast<size_t>(40), cleanedJson.length() - start);
-                std::string context = cleanedJson.substr(start, contextLength);
+                std::string context(cleanedJson.substr(start, contextLength));
                 
                 errorMsg += "\nContext around error position " + std::to_string(e.byte) + ": '" + context + "'";
                 
@@ -107,7 +102,7 @@ BitCoin::json BitCoin::fetch()
                 // Show more context around this specific problematic area
                 if (cleanedJson.length() > 2750) {
                     errorMsg += "\nExtended context (2720-2760): '" + 
-                               cleanedJson.substr(2720, 40) + "'";
+                               std::string(cleanedJson.substr(2720, 40)) + "'";
                 }
             }
             
@@ -116,11 +111,95 @@ BitCoin::json BitCoin::fetch()
         
     } catch (const std::exception& e) {
         // Re-throw with additional context
-        throw std::runtime_error("BitCoin::fetch() failed: " + std::string(e.what()));
+        throw std::runtime_error("TickerClient::fetch() failed: " + std::string(e.what()));
+    }
+}
+
+Snapshot TickerClient::fetchSnapshot(const TickerDecoder& decoder)
+{
+    Snapshot snapshot;
+    this->fetchSnapshot(decoder, snapshot);
+    return snapshot;
+}
+
+void TickerClient::fetchSnapshot(const TickerDecoder& decoder, Snapshot& out)
+{
+    using Clock = std::chrono::steady_clock;
+    try {
+        const auto start = Clock::now();
+        this->curlHandle.fetch();
+        const auto fetched = Clock::now();
+        this->stageTimes.fetch = fetched - start;
+        this->decode(decoder, validateAndCleanJson(this->curlHandle.getFetchedData()), out);
+        out.freshness = this->curlHandle.freshness();
+        this->stageTimes.decode = Clock::now() - fetched;
+    } catch (const std::exception& e) {
+        throw std::runtime_error("TickerClient::fetchSnapshot() failed: " + std::string(e.what()));
+    }
+}
+
+std::string TickerClient::fetchPayload()
+{
+    using Clock = std::chrono::steady_clock;
+    try {
+        const auto start = Clock::now();
+        this->curlHandle.fetch();
+        this->stageTimes = {Clock::now() - start, {}};
+        return this->curlHandle.takeFetchedData();
+    } catch (const std::exception& e) {
+        throw std::runtime_error("TickerClient::fetchPayload() failed: " + std::string(e.what()));
+    }
+}
+
+TickerClient::TickerClient(const std::string& url):curlHandle({})
+{
+    this->curlHandle.setUrl(url);
+}
+
+void TickerClient::pinAddress(const ResolvedAddress& resolved)
+{
+    this->curlHandle.setResolvedAddress(resolved.host, resolved.port, resolved.addresses);
+}
+
+namespace {
+template <class T>
+std::unique_ptr<TickerClient> createTicker(const std::string& url)
+{
+    return std::make_unique<T>(url);
+}
+
+template <class T>
+void decodeTicker(const TickerDecoder& decoder, std::string_view json, Snapshot& out)
+{
+    decoder.decodeAs<typename T::ProviderType::Schema>(json, out);
+}
+
+template <class T>
+constexpr TickerKind kindOf(const char* name)
+{
+    return {name, T::AssetType::INFO, T::DEFAULT_URL, createTicker<T>, decodeTicker<T>};
+}
+
+const TickerKind TICKER_KINDS[] = {
+    kindOf<BitCoin>("btc"),
+    kindOf<EtherTicker>("eth"),
+};
+}  // namespace
+
+const TickerKind& TickerKind::find(std::string_view name)
+{
+    for (const TickerKind& kind : TICKER_KINDS) {
+        if (name == kind.name) return kind;
     }
+    throw std::invalid_argument("Unknown asset '" + std::string(name) + "' (expected " + names() + ")");
 }
 
-BitCoin::BitCoin():curlHandle({})
+std::string TickerKind::names()
 {
-    this->curlHandle.setUrl(this->URL);
-}
\ No newline at end of file
+    std::string names;
+    for (const TickerKind& kind : TICKER_KINDS) {
+        if (!names.empty()) names += ", ";
+        names += kind.name;
+    }
+    return names;
+}
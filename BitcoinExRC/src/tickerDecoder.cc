@@ -0,0 +1,119 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/tickerDecoder.h"
+
+#include <bit>
+#include <iterator>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TICKER_DECODER_SSE2 1
+#endif
+
+#include "../include/ticker.h"
+
+namespace {
+// Quotes, backslashes and brackets: the only bytes that matter when
+// skipping a value. '[' and ']' are '{' and '}' with bit 0x20 cleared.
+bool structural(char c) {
+  const char folded = static_cast<char>(c | 0x20);
+  return c == '"' || c == '\\' || folded == '{' || folded == '}';
+}
+
+#if defined(TICKER_DECODER_SSE2)
+// Bit i set if p[i] is structural, for the 16 bytes at p.
+unsigned structuralMask(const char* p) {
+  const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  const __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+  const __m128i hits = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')),
+                   _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))),
+      _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+                   _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))));
+  return static_cast<unsigned>(_mm_movemask_epi8(hits));
+}
+#endif
+}  // namespace
+
+namespace tickerDecoderDetail {
+// Skipping a symbol the filter rejects is most of the work of a narrow
+// projection, so this visits only the structural bytes: 16 at a time are
+// tested at once and the set bits walked in order.
+std::size_t skipComposite(std::string_view text, std::size_t pos) {
+  const char* const data = text.data();
+  const char* const end = data + text.size();
+  int depth = 0;
+  bool inString = false;
+  // Handles the structural byte at `at`; returns where scanning resumes,
+  // or nullptr once the value is closed.
+  auto visit = [&](const char* at) -> const char* {
+    switch (*at) {
+      case '"':
+        inString = !inString;
+        break;
+      case '\\':
+        if (inString) return at + 2;  // the escaped byte is not structural
+        break;
+      case '{':
+      case '[':
+        if (!inString) ++depth;
+        break;
+      default:  // '}' or ']'
+        if (!inString && --depth == 0) return nullptr;
+        break;
+    }
+    return at + 1;
+  };
+
+  const char* p = data + pos;
+  while (p < end) {
+#if defined(TICKER_DECODER_SSE2)
+    if (end - p >= 16) {
+      const char* block = p;
+      unsigned mask = structuralMask(block);
+      p += 16;
+      while (mask != 0) {
+        const char* at = block + std::countr_zero(mask);
+        const char* resume = visit(at);
+        if (resume == nullptr) return static_cast<std::size_t>(at - data) + 1;
+        if (resume != at + 1) {  // after an escape: rescan from there
+          p = resume;
+          break;
+        }
+        mask &= mask - 1;
+      }
+      continue;
+    }
+#endif
+    if (!structural(*p)) {
+      ++p;
+      continue;
+    }
+    const char* resume = visit(p);
+    if (resume == nullptr) return static_cast<std::size_t>(p - data) + 1;
+    p = resume;
+  }
+  return std::string_view::npos;
+}
+}  // namespace tickerDecoderDetail
+
+SymbolFilter::SymbolFilter(std::vector<std::string> symbols)
+    : symbols(std::make_move_iterator(symbols.begin()),
+              std::make_move_iterator(symbols.end())) {}
+
+bool SymbolFilter::accepts(std::string_view symbol) const {
+  if (this->symbols.empty()) return true;
+  return this->symbols.find(symbol) != this->symbols.end();
+}
+
+TickerDecoder::TickerDecoder(SymbolFilter filter) : filter(std::move(filter)) {}
+
+Snapshot TickerDecoder::decode(std::string_view json) const {
+  Snapshot snapshot;
+  this->decode(json, snapshot);
+  return snapshot;
+}
+
+void TickerDecoder::decode(std::string_view json, Snapshot& out) const {
+  this->decodeAs<BlockchainInfo::Schema>(json, out);
+}
@@ -0,0 +1,39 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/tickerGenerator.h"
+
+#include <fmt/format.h>
+
+#include <iterator>
+
+std::string syntheticSymbol(std::size_t index) {
+  std::size_t width = 3;
+  for (std::size_t block = 26 * 26 * 26; index >= block; block *= 26) {
+    index -= block;
+    ++width;
+  }
+  std::string code(width, 'A');
+  for (std::size_t k = width; k-- > 0; index /= 26) {
+    code[k] = static_cast<char>('A' + index % 26);
+  }
+  return code;
+}
+
+std::string syntheticTicker(std::size_t symbols, std::uint64_t tick) {
+  std::string out;
+  out.reserve(16 + symbols * 112);
+  out += '{';
+  auto it = std::back_inserter(out);
+  for (std::size_t i = 0; i < symbols; ++i) {
+    double price = 1000.0 + static_cast<double>(i * 7919 % 100000) + 0.37;
+    price += static_cast<double>((i + tick * 13) % 41) *
+             static_cast<double>(tick % 5) * 0.01;
+    if (i) out += ',';
+    fmt::format_to(
+        it,
+        "\"{0}\":{{\"15m\":{1:.2f},\"last\":{1:.2f},\"buy\":{2:.2f},"
+        "\"sell\":{3:.2f},\"symbol\":\"{0}\"}}",
+        syntheticSymbol(i), price, price + 0.5, price - 0.5);
+  }
+  out += '}';
+  return out;
+}
@@ -0,0 +1,87 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/tickerPoller.h"
+
+#include <exception>
+
+#include "../include/tickScheduler.h"
+#include "../include/trace.h"
+
+TickerPoller::TickerPoller(TickerClient& ticker, const TickerDecoder& decoder,
+                           std::chrono::milliseconds interval,
+                           bool alignToWallClock, std::size_t maxReaders)
+    : ticker(ticker),
+      decoder(decoder),
+      interval(interval),
+      alignToWallClock(alignToWallClock),
+      cell(maxReaders) {}
+
+TickerPoller::~TickerPoller() { this->stop(); }
+
+void TickerPoller::start() {
+  if (this->thread.joinable()) return;
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->stopping = false;
+  }
+  this->thread = std::thread([this] {
+    Tracer::nameThread("ticker poller");
+    this->run();
+  });
+}
+
+void TickerPoller::stop() {
+  if (!this->thread.joinable()) return;
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->stopping = true;
+  }
+  this->wake.notify_all();
+  this->thread.join();
+}
+
+bool TickerPoller::waitForFirst(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> guard(this->lock);
+  return this->wake.wait_for(guard, timeout, [this] {
+    return this->counters.published > 0 || this->stopping;
+  }) && this->counters.published > 0;
+}
+
+TickerPoller::Stats TickerPoller::stats() const {
+  std::lock_guard<std::mutex> guard(this->lock);
+  return this->counters;
+}
+
+std::string TickerPoller::lastError() const {
+  std::lock_guard<std::mutex> guard(this->lock);
+  return this->error;
+}
+
+void TickerPoller::run() {
+  TickScheduler scheduler(this->interval, this->alignToWallClock);
+  std::unique_lock<std::mutex> guard(this->lock);
+  while (!this->stopping) {
+    guard.unlock();
+    bool published = false;
+    std::string failure;
+    try {
+      TRACE_SPAN("poll");
+      // The draft is a retired snapshot no reader can still see; the
+      // decoder clears it before filling it in.
+      this->ticker.fetchSnapshot(this->decoder, this->cell.draft());
+      this->cell.publish();
+      published = true;
+    } catch (const std::exception& e) {
+      failure = e.what();
+    }
+    guard.lock();
+    if (published) {
+      ++this->counters.published;
+    } else {
+      ++this->counters.errors;
+      this->error = std::move(failure);
+    }
+    this->wake.notify_all();
+    this->wake.wait_until(guard, scheduler.next(),
+                          [this] { return this->stopping; });
+  }
+}
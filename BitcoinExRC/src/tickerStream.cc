@@ -0,0 +1,244 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/tickerStream.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "../include/shutdown.h"
+
+namespace {
+constexpr auto MIN_BACKOFF = std::chrono::milliseconds(250);
+constexpr auto MAX_BACKOFF = std::chrono::milliseconds(8000);
+
+// Doubling backoff with +-20% jitter so a fleet does not reconnect in step.
+std::chrono::milliseconds backoff(unsigned failures) {
+  static std::minstd_rand rng(std::random_device{}());
+  auto delay = MIN_BACKOFF * (1LL << std::min(failures, 5u));
+  delay = std::min<std::chrono::milliseconds>(delay, MAX_BACKOFF);
+  std::uniform_real_distribution<double> jitter(0.8, 1.2);
+  return std::chrono::milliseconds(
+      static_cast<long long>(static_cast<double>(delay.count()) * jitter(rng)));
+}
+
+// Envelope fields sit before "ticker", which the server always sends last,
+// so the header can be scanned without touching the payload.
+struct Envelope {
+  std::string_view type;
+  std::uint64_t seq = 0;
+  std::int64_t sentUs = -1;
+  std::string_view ticker;
+};
+
+template <class Int>
+bool readInt(std::string_view header, std::string_view key, Int& out) {
+  const auto at = header.find(key);
+  if (at == std::string_view::npos) return false;
+  const char* first = header.data() + at + key.size();
+  return std::from_chars(first, header.data() + header.size(), out).ec ==
+         std::errc();
+}
+
+Envelope parseEnvelope(std::string_view message) {
+  constexpr std::string_view TICKER = "\"ticker\":";
+  const auto at = message.find(TICKER);
+  const auto close = message.find_last_of('}');
+  if (at == std::string_view::npos || close == std::string_view::npos ||
+      close < at) {
+    throw std::runtime_error("Stream message has no ticker payload");
+  }
+  Envelope envelope;
+  const std::string_view header = message.substr(0, at);
+  envelope.ticker =
+      message.substr(at + TICKER.size(), close - at - TICKER.size());
+  constexpr std::string_view TYPE = "\"type\":\"";
+  const auto type = header.find(TYPE);
+  if (type != std::string_view::npos) {
+    const auto start = type + TYPE.size();
+    envelope.type = header.substr(start, header.find('"', start) - start);
+  }
+  if (!readInt(header, "\"seq\":", envelope.seq)) {
+    throw std::runtime_error("Stream message has no seq");
+  }
+  readInt(header, "\"sent\":", envelope.sentUs);
+  return envelope;
+}
+
+std::int64_t epochMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+}  // namespace
+
+TickerStream::TickerStream(std::string url, const TickerDecoder& decoder)
+    : url(std::move(url)), decoder(decoder) {
+  if (this->url.empty()) {
+    throw std::invalid_argument("Stream URL cannot be empty");
+  }
+}
+
+void TickerStream::connect() {
+#ifdef CURLWS_TEXT
+  curl_ptr curl(CurlHandler::createHandle(), CurlHandler::deleter);
+  if (!curl) throw std::runtime_error("Failed to initialize curl");
+  curl_easy_setopt(curl.get(), CURLOPT_URL, this->url.c_str());
+  // 2 = WebSocket connect-only: perform() does the upgrade and returns, then
+  // frames go through curl_ws_send()/curl_ws_recv().
+  curl_easy_setopt(curl.get(), CURLOPT_CONNECT_ONLY, 2L);
+  curl_easy_setopt(curl.get(), CURLOPT_CONNECTTIMEOUT, 10L);
+  curl_easy_setopt(curl.get(), CURLOPT_USERAGENT, "BitcoinTracker/1.0");
+  curl_easy_setopt(curl.get(), CURLOPT_TCP_KEEPALIVE, 1L);
+  const CURLcode res = curl_easy_perform(curl.get());
+  if (res != CURLE_OK) {
+    throw std::runtime_error(std::string("Stream connect failed: ") +
+                             curl_easy_strerror(res));
+  }
+  curl_socket_t fd = CURL_SOCKET_BAD;
+  curl_easy_getinfo(curl.get(), CURLINFO_ACTIVESOCKET, &fd);
+  if (fd == CURL_SOCKET_BAD) {
+    throw std::runtime_error("Stream connect failed: no socket");
+  }
+  this->handle = std::move(curl);
+  this->socket = static_cast<std::intptr_t>(fd);
+  this->message.clear();
+  this->send(fmt::format("{{\"op\":\"subscribe\",\"since\":{}}}", this->seq));
+#else
+  throw std::runtime_error("libcurl is too old for WebSocket streaming");
+#endif
+}
+
+void TickerStream::disconnect(std::chrono::milliseconds retryIn) {
+  if (this->handle) ++this->counters.reconnects;
+  this->handle.reset();
+  this->socket = -1;
+  this->message.clear();
+  this->retryAt = std::chrono::steady_clock::now() + retryIn;
+}
+
+void TickerStream::send(std::string_view text) {
+#ifdef CURLWS_TEXT
+  while (!text.empty()) {
+    std::size_t sent = 0;
+    const CURLcode res = curl_ws_send(this->handle.get(), text.data(),
+                                      text.size(), &sent, 0, CURLWS_TEXT);
+    if (res == CURLE_AGAIN) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    if (res != CURLE_OK) {
+      throw std::runtime_error(std::string("Stream send failed: ") +
+                               curl_easy_strerror(res));
+    }
+    text.remove_prefix(sent);
+  }
+#endif
+}
+
+bool TickerStream::receive() {
+#ifdef CURLWS_TEXT
+  char buffer[16384];
+  for (;;) {
+    std::size_t got = 0;
+    const curl_ws_frame* meta = nullptr;
+    const CURLcode res = curl_ws_recv(this->handle.get(), buffer,
+                                      sizeof(buffer), &got, &meta);
+    if (res == CURLE_AGAIN) return false;
+    if (res != CURLE_OK) {
+      throw std::runtime_error(std::string("Stream receive failed: ") +
+                               curl_easy_strerror(res));
+    }
+    if (meta->flags & CURLWS_CLOSE) {
+      throw std::runtime_error("Stream closed by server");
+    }
+    // Pings are answered by libcurl; only text frames carry messages.
+    if (!(meta->flags & CURLWS_TEXT)) continue;
+    this->message.append(buffer, got);
+    if (meta->bytesleft == 0 && !(meta->flags & CURLWS_CONT)) return true;
+  }
+#else
+  return false;
+#endif
+}
+
+bool TickerStream::apply(std::string_view text, Snapshot& snapshot) {
+  const Envelope envelope = parseEnvelope(text);
+  if (envelope.type == "snapshot") {
+    this->decoder.decode(envelope.ticker, snapshot);
+    ++this->counters.snapshots;
+  } else {
+    if (envelope.seq <= this->seq) return false;  // replayed duplicate
+    if (this->seq == 0 || envelope.seq != this->seq + 1) {
+      ++this->counters.gaps;
+      this->disconnect(std::chrono::milliseconds(0));
+      return false;
+    }
+    this->decoder.decode(envelope.ticker, this->scratch);
+    for (std::size_t i = 0; i < this->scratch.size(); ++i) {
+      const auto index = snapshot.indexOf(this->scratch.symbols[i]);
+      if (!index) {
+        snapshot.push(this->scratch.symbols[i], this->scratch.m15[i],
+                      this->scratch.last[i], this->scratch.buy[i],
+                      this->scratch.sell[i]);
+        continue;
+      }
+      snapshot.m15[*index] = this->scratch.m15[i];
+      snapshot.last[*index] = this->scratch.last[i];
+      snapshot.buy[*index] = this->scratch.buy[i];
+      snapshot.sell[*index] = this->scratch.sell[i];
+    }
+    if (!this->scratch.empty()) snapshot.fetchedAt = this->scratch.fetchedAt;
+  }
+  this->seq = envelope.seq;
+  this->failures = 0;
+  ++this->counters.messages;
+  if (envelope.sentUs >= 0) {
+    const double us = static_cast<double>(epochMicros() - envelope.sentUs);
+    Stats& c = this->counters;
+    c.latencyMinUs = c.latencySamples == 0 ? us : std::min(c.latencyMinUs, us);
+    c.latencyMaxUs = std::max(c.latencyMaxUs, us);
+    c.latencySumUs += us;
+    ++c.latencySamples;
+    // A push carries its own send time, taken on the server's clock with
+    // no Date to correct it by; close enough for the age column.
+    snapshot.freshness = {};
+    snapshot.freshness.sourceAt = Freshness::Clock::time_point(
+        std::chrono::microseconds(envelope.sentUs));
+  }
+  // Updates that only touched symbols the filter drops change nothing.
+  return envelope.type == "snapshot" || !this->scratch.empty();
+}
+
+std::size_t TickerStream::waitForUpdates(
+    Snapshot& snapshot, std::chrono::steady_clock::time_point deadline) {
+  std::size_t applied = 0;
+  try {
+    for (;;) {
+      if (!this->connected()) {
+        if (!sleepUntilOrShutdown(std::min(this->retryAt, deadline)) ||
+            std::chrono::steady_clock::now() < this->retryAt) {
+          return applied;
+        }
+        this->connect();
+      }
+      while (this->connected() && this->receive()) {
+        if (this->apply(this->message, snapshot)) ++applied;
+        this->message.clear();
+      }
+      if (applied > 0) return applied;
+      if (!this->connected()) continue;  // seq gap: resubscribe now
+      if (waitReadableOrShutdown(this->socket, deadline) !=
+          WakeReason::Readable) {
+        return applied;
+      }
+    }
+  } catch (const std::exception&) {
+    this->disconnect(backoff(this->failures++));
+    throw;
+  }
+}
@@ -0,0 +1,157 @@
+// Copyright(c)2022 Vishal Ahirwar.
+#include "../include/trace.h"
+
+#ifdef BITCOINEXRC_TRACING
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+struct Span {
+  const char* name;
+  std::uint64_t start;
+  std::uint64_t end;
+};
+
+// One per thread that ever recorded a span. Owned by the registry, not the
+// thread, so spans of pool and pipeline threads survive until write().
+struct Ring {
+  static constexpr std::size_t CAPACITY = 8192;
+  std::array<Span, CAPACITY> spans;
+  std::atomic<std::uint64_t> written{0};
+  std::uint32_t tid = 0;
+  const char* threadName = nullptr;
+};
+
+std::mutex registryLock;
+std::vector<std::unique_ptr<Ring>>& registry() {
+  static std::vector<std::unique_ptr<Ring>> rings;
+  return rings;
+}
+
+// Constant-initialized, so reaching it costs no thread_local init guard.
+thread_local Ring* threadRing = nullptr;
+
+Ring& ringForThread() {
+  if (threadRing == nullptr) {
+    auto ring = std::make_unique<Ring>();
+    std::lock_guard<std::mutex> guard(registryLock);
+    ring->tid = static_cast<std::uint32_t>(registry().size() + 1);
+    threadRing = ring.get();
+    registry().push_back(std::move(ring));
+  }
+  return *threadRing;
+}
+
+// JSON string body; span and thread names are plain literals, but be safe.
+std::string escaped(const char* text) {
+  std::string out;
+  for (const char* p = text; *p; ++p) {
+    if (*p == '"' || *p == '\\') out += '\\';
+    out += *p;
+  }
+  return out;
+}
+
+// Tick count and steady_clock time at start(), for converting raw span
+// timestamps to nanoseconds in write().
+struct Calibration {
+  std::uint64_t ticks = 0;
+  std::chrono::steady_clock::time_point at;
+};
+Calibration startPoint;
+
+Calibration calibrate() {
+  return Calibration{Tracer::now(), std::chrono::steady_clock::now()};
+}
+}  // namespace
+
+std::atomic<bool> Tracer::active{false};
+
+void Tracer::start() {
+  ringForThread();  // the starting thread gets the first track
+  if (!enabled()) startPoint = calibrate();
+  active.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::nameThread(const char* name) {
+  if (!enabled()) return;
+  ringForThread().threadName = name;
+}
+
+void Tracer::record(const char* name, std::uint64_t start,
+                    std::uint64_t end) {
+  Ring& ring = ringForThread();
+  const std::uint64_t slot = ring.written.load(std::memory_order_relaxed);
+  ring.spans[slot % Ring::CAPACITY] = Span{name, start, end};
+  ring.written.store(slot + 1, std::memory_order_release);
+}
+
+std::size_t Tracer::write(const std::string& path) {
+  std::FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    throw std::runtime_error("Cannot write trace to " + path);
+  }
+  std::lock_guard<std::mutex> guard(registryLock);
+  // Nanoseconds per raw tick over the whole run; 1 without a TSC.
+  const Calibration endPoint = calibrate();
+  double nsPerTick = 1.0;
+  if (endPoint.ticks > startPoint.ticks) {
+    nsPerTick = std::chrono::duration<double, std::nano>(endPoint.at -
+                                                         startPoint.at)
+                    .count() /
+                static_cast<double>(endPoint.ticks - startPoint.ticks);
+  }
+  const double usPerTick = nsPerTick / 1e3;
+  // Timestamps relative to the earliest span keep the numbers short.
+  std::uint64_t origin = UINT64_MAX;
+  for (const auto& ring : registry()) {
+    const std::uint64_t written = ring->written.load(std::memory_order_acquire);
+    const std::uint64_t first =
+        written > Ring::CAPACITY ? written - Ring::CAPACITY : 0;
+    for (std::uint64_t i = first; i < written; ++i) {
+      origin = std::min(origin, ring->spans[i % Ring::CAPACITY].start);
+    }
+  }
+
+  std::size_t count = 0;
+  fmt::print(file, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  const char* separator = "\n";
+  for (const auto& ring : registry()) {
+    const char* name = ring->threadName;
+    fmt::print(file,
+               "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+               "\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+               separator, ring->tid,
+               name ? escaped(name) : fmt::format("thread {}", ring->tid));
+    separator = ",\n";
+    const std::uint64_t written = ring->written.load(std::memory_order_acquire);
+    const std::uint64_t first =
+        written > Ring::CAPACITY ? written - Ring::CAPACITY : 0;
+    for (std::uint64_t i = first; i < written; ++i) {
+      const Span& span = ring->spans[i % Ring::CAPACITY];
+      fmt::print(file,
+                 ",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},"
+                 "\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                 escaped(span.name), ring->tid,
+                 static_cast<double>(span.start - origin) * usPerTick,
+                 static_cast<double>(span.end - span.start) * usPerTick);
+      ++count;
+    }
+  }
+  fmt::print(file, "\n]}}\n");
+  const bool failed = std::ferror(file) != 0;
+  if (std::fclose(file) != 0 || failed) {
+    throw std::runtime_error("Failed writing trace to " + path);
+  }
+  return count;
+}
+
+#endif  // BITCOINEXRC_TRACING
@@ -5,6 +5,7 @@ set(CMAKE_CXX_STANDARD_REQUIRED True)
 set(CMAKE_EXPORT_COMPILE_COMMANDS ON)
 option(STATIC_LINK "Enable static linking" ON)
 option(ENABLE_TESTS "GTests" OFF)
+option(ENABLE_TRACING "Compile in --trace spans" ON)
 if(STATIC_LINK)
   set(BUILD_SHARED_LIBS OFF)
   if (WIN32)
@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+# Copyright(c)2022 Vishal Ahirwar.
+"""Local stand-in for the blockchain.info ticker endpoint.
+
+Serves a synthetic ticker at /ticker, and the same prices as a push stream
+at /ws (WebSocket, protocol documented in include/tickerStream.h), so
+startup and streaming can be measured without the network. /eth/ticker
+serves ETH prices in a different field schema, for --asset eth:
+
+    python3 tools/standin_server.py --port 8080 &
+    BitcoinExRC --once --ttfp --url http://127.0.0.1:8080/ticker
+    BitcoinExRC --bench startup --url http://127.0.0.1:8080/ticker
+    BitcoinExRC --stream ws://127.0.0.1:8080/ws --format ndjson
+    BitcoinExRC --asset eth --once --url http://127.0.0.1:8080/eth/ticker
+
+With --tls CERT KEY it serves HTTPS instead, for handshake measurements
+(a self-signed pair will do: the client checks the name, not the issuer):
+
+    openssl req -x509 -newkey rsa:2048 -nodes -days 30 -subj /CN=localhost \\
+        -addext subjectAltName=IP:127.0.0.1 -keyout key.pem -out cert.pem
+    python3 tools/standin_server.py --port 8443 --tls cert.pem key.pem &
+    BitcoinExRC --bench tls --url https://127.0.0.1:8443/ticker
+"""
+import argparse
+import base64
+import collections
+import hashlib
+import http.server
+import json
+import random
+import ssl
+import struct
+import threading
+import time
+
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+
+def synthetic_symbol(i):
+    code = ""
+    for _ in range(3):
+        code = chr(ord("A") + i % 26) + code
+        i //= 26
+    return code
+
+
+def quote(last):
+    return {
+        "15m": last,
+        "last": last,
+        "buy": round(last - 0.5, 2),
+        "sell": round(last + 0.5, 2),
+    }
+
+
+class Feed:
+    """Ticker state plus a bounded history of updates for resume."""
+
+    def __init__(self, symbols, history, seed=42):
+        self.rng = random.Random(seed)
+        self.names = ["USD" if i == 0 else synthetic_symbol(i)
+                      for i in range(symbols)]
+        self.prices = {name: 1000.0 + (i * 7919 % 100000) + 0.37
+                       for i, name in enumerate(self.names)}
+        self.seq = 0
+        self.history = collections.deque(maxlen=history)
+        self.cond = threading.Condition()
+
+    def ticker(self, names=None):
+        body = {}
+        for name in names or self.names:
+            body[name] = dict(quote(round(self.prices[name], 2)),
+                              symbol=name)
+        return body
+
+    def eth_ticker(self):
+        # Same moves, scaled to an ETH price and in the ETH feed's schema.
+        body = {}
+        for name in self.names:
+            last = round(self.prices[name] / 20.0, 2)
+            body[name] = {"price": last, "bid": round(last - 0.05, 2),
+                          "ask": round(last + 0.05, 2), "open_15m": last}
+        return body
+
+    def tick(self, moves):
+        with self.cond:
+            changed = self.rng.sample(self.names, min(moves, len(self.names)))
+            for name in changed:
+                self.prices[name] *= 1 + self.rng.uniform(-0.001, 0.001)
+            self.seq += 1
+            self.history.append((self.seq, self.ticker(changed)))
+            self.cond.notify_all()
+
+    def message(self, kind, seq, ticker):
+        # "ticker" goes last; the client scans the header before it.
+        envelope = '{{"type":"{}","seq":{},"sent":{},"ticker":'.format(
+            kind, seq, time.time_ns() // 1000)
+        return envelope + json.dumps(ticker) + "}"
+
+
+def ws_frame(text):
+    payload = text.encode()
+    header = bytearray([0x81])
+    if len(payload) < 126:
+        header.append(len(payload))
+    elif len(payload) < 1 << 16:
+        header.append(126)
+        header += struct.pack(">H", len(payload))
+    else:
+        header.append(127)
+        header += struct.pack(">Q", len(payload))
+    return bytes(header) + payload
+
+
+def ws_read(rfile):
+    """Reads one client frame; returns (opcode, payload)."""
+    head = rfile.read(2)
+    if len(head) < 2:
+        return 0x8, b""
+    opcode, length = head[0] & 0x0F, head[1] & 0x7F
+    if length == 126:
+        length = struct.unpack(">H", rfile.read(2))[0]
+    elif length == 127:
+        length = struct.unpack(">Q", rfile.read(8))[0]
+    mask = rfile.read(4) if head[1] & 0x80 else b"\0\0\0\0"
+    data = rfile.read(length)
+    return opcode, bytes(b ^ mask[i % 4] for i, b in enumerate(data))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--symbols", type=int, default=32)
+    parser.add_argument("--delay-ms", type=float, default=0,
+                        help="artificial latency before each HTTP response")
+    parser.add_argument("--ws-interval-ms", type=float, default=100,
+                        help="time between pushed updates")
+    parser.add_argument("--ws-moves", type=int, default=3,
+                        help="symbols changed per pushed update")
+    parser.add_argument("--ws-drop-after", type=int, default=0,
+                        help="close each stream after N messages, to "
+                             "exercise resume (0 = never)")
+    parser.add_argument("--ws-history", type=int, default=1024,
+                        help="updates kept for resume")
+    parser.add_argument("--tls", nargs=2, metavar=("CERT", "KEY"),
+                        help="serve HTTPS with this certificate and key")
+    args = parser.parse_args()
+    feed = Feed(args.symbols, args.ws_history)
+
+    def ticker_loop():
+        while True:
+            time.sleep(args.ws_interval_ms / 1000.0)
+            feed.tick(args.ws_moves)
+
+    threading.Thread(target=ticker_loop, daemon=True).start()
+
+    class Handler(http.server.BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def do_GET(self):
+            path = self.path.split("?")[0]
+            if path == "/ws":
+                self.stream()
+                return
+            if path not in ("/ticker", "/eth/ticker"):
+                self.send_error(404)
+                return
+            if args.delay_ms:
+                time.sleep(args.delay_ms / 1000.0)
+            with feed.cond:
+                body = feed.ticker() if path == "/ticker" else feed.eth_ticker()
+                payload = json.dumps(body).encode()
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(payload)))
+            self.end_headers()
+            self.wfile.write(payload)
+
+        def stream(self):
+            key = self.headers.get("Sec-WebSocket-Key")
+            if key is None:
+                self.send_error(400)
+                return
+            accept = base64.b64encode(
+                hashlib.sha1((key + WS_GUID).encode()).digest()).decode()
+            self.send_response(101)
+            self.send_header("Upgrade", "websocket")
+            self.send_header("Connection", "Upgrade")
+            self.send_header("Sec-WebSocket-Accept", accept)
+            self.end_headers()
+            self.wfile.flush()
+            self.close_connection = True
+
+            opcode, payload = ws_read(self.rfile)
+            if opcode != 0x1:
+                return
+            since = int(json.loads(payload).get("since", 0))
+            sent = 0
+            with feed.cond:
+                oldest = feed.history[0][0] if feed.history else feed.seq + 1
+                if since == 0 or since + 1 < oldest or since > feed.seq:
+                    backlog = [feed.message("snapshot", feed.seq,
+                                            feed.ticker())]
+                else:
+                    backlog = [feed.message("update", seq, ticker)
+                               for seq, ticker in feed.history if seq > since]
+                position = feed.seq
+            try:
+                while True:
+                    for text in backlog:
+                        self.wfile.write(ws_frame(text))
+                        sent += 1
+                        if args.ws_drop_after and sent >= args.ws_drop_after:
+                            return
+                    self.wfile.flush()
+                    with feed.cond:
+                        feed.cond.wait_for(lambda: feed.seq > position)
+                        backlog = [feed.message("update", seq, ticker)
+                                   for seq, ticker in feed.history
+                                   if seq > position]
+                        position = feed.seq
+            except (BrokenPipeError, ConnectionResetError):
+                pass
+
+        def log_message(self, *_):
+            pass
+
+    server = http.server.ThreadingHTTPServer(("127.0.0.1", args.port), Handler)
+    server.daemon_threads = True
+    if args.tls:
+        # One context for the server's lifetime, so the session tickets it
+        # issues stay valid for resumption across client processes.
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(*args.tls)
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()